@@ -0,0 +1,217 @@
+/**
+ * @file FixedString.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief String with a fixed capacity for the messagetypes
+ * @version 0.1
+ * @date 2020-03-30
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef FIXEDSTRING_H__
+#define FIXEDSTRING_H__
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <type_traits>
+
+/**
+ * @brief Type of the length of a FixedString<N>, the smallest one that holds N
+ *
+ * @tparam N - maximum number of characters
+ */
+template <size_t N>
+struct FixedStringLength
+{
+    static_assert(N <= 0xFFFF, "FixedString holds at most 65535 characters");
+    typedef typename std::conditional<(N <= 0xFF), uint8_t, uint16_t>::type type;
+};
+
+/**
+ * @brief Access to a FixedString whose capacity is only known at runtime
+ *
+ * Every FixedString<N> starts with its length followed by its characters,
+ * so the field tables can read and write them from N and the address.
+ *
+ */
+class FixedStringAccess
+{
+public:
+
+    /**
+     * @brief Number of bytes of the length of a FixedString<N>
+     *
+     * @param capacity - N
+     * @return size_t
+     */
+    static constexpr size_t lengthBytes(size_t capacity)
+    {
+        return capacity <= 0xFF ? sizeof(uint8_t) : sizeof(uint16_t);
+    }
+
+    /**
+     * @brief Characters of the string
+     *
+     * @param string - address of a FixedString<N>
+     * @param capacity - N
+     * @return const char* - null-terminated
+     */
+    static const char* characters(const void* string, size_t capacity)
+    {
+        return static_cast<const char*>(string) + lengthBytes(capacity);
+    }
+
+    /**
+     * @brief Number of characters of the string
+     *
+     * @param string - address of a FixedString<N>
+     * @param capacity - N
+     * @return size_t
+     */
+    static size_t length(const void* string, size_t capacity)
+    {
+        return capacity <= 0xFF ? *static_cast<const uint8_t*>(string) : *static_cast<const uint16_t*>(string);
+    }
+
+    /**
+     * @brief Replace the characters, truncated to the capacity
+     *
+     * @param string - address of a FixedString<N>
+     * @param capacity - N
+     * @param value - characters, need not be null-terminated
+     * @param length
+     * @return true
+     * @return false - the value was truncated
+     */
+    static bool assign(void* string, size_t capacity, const char* value, size_t length)
+    {
+        bool fits = length <= capacity;
+        size_t size = fits ? length : capacity;
+        char* characters = static_cast<char*>(string) + lengthBytes(capacity);
+        memcpy(characters, value, size);
+        characters[size] = '\0';
+        if (capacity <= 0xFF)
+        {
+            *static_cast<uint8_t*>(string) = (uint8_t)size;
+        }
+        else
+        {
+            *static_cast<uint16_t*>(string) = (uint16_t)size;
+        }
+        return fits;
+    }
+};
+
+/**
+ * @brief Null-terminated string stored inline, without heap use
+ *
+ * Trivially copyable and only one or two bytes larger than its characters,
+ * so the fields structs and the value types of MessageValue.h stay plain
+ * data. Longer values are truncated and reported by assign.
+ *
+ * @tparam N - maximum number of characters
+ */
+template <size_t N>
+class FixedString
+{
+private:
+
+    typename FixedStringLength<N>::type size;   ///< number of characters, must stay first
+    char characters[N + 1];                     ///< characters and the terminating null
+
+public:
+
+    /**
+     * @brief Construct an empty string
+     *
+     */
+    FixedString() : size(0)
+    {
+        static_assert(offsetof(FixedString, characters) == FixedStringAccess::lengthBytes(N), "FixedStringAccess expects the characters after the length");
+        this->characters[0] = '\0';
+    }
+
+    /**
+     * @brief Construct a string from a literal, truncated to the capacity
+     *
+     * @param value
+     */
+    FixedString(const char* value) : FixedString()
+    {
+        this->assign(value, strlen(value));
+    }
+
+    /**
+     * @brief Replace the characters
+     *
+     * @param value - characters, need not be null-terminated
+     * @param length
+     * @return true
+     * @return false - the value was truncated to the capacity
+     */
+    bool assign(const char* value, size_t length)
+    {
+        return FixedStringAccess::assign(this, N, value, length);
+    }
+
+    FixedString& operator=(const char* value)
+    {
+        this->assign(value, strlen(value));
+        return *this;
+    }
+
+    FixedString& operator=(const String& value)
+    {
+        this->assign(value.c_str(), value.length());
+        return *this;
+    }
+
+    const char* c_str() const
+    {
+        return this->characters;
+    }
+
+    size_t length() const
+    {
+        return this->size;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    bool operator==(const char* value) const
+    {
+        return strcmp(this->characters, value) == 0;
+    }
+
+    bool operator!=(const char* value) const
+    {
+        return !(*this == value);
+    }
+
+    bool operator==(const String& value) const
+    {
+        return this->size == value.length() && memcmp(this->characters, value.c_str(), this->size) == 0;
+    }
+
+    bool operator!=(const String& value) const
+    {
+        return !(*this == value);
+    }
+
+    template <size_t M>
+    bool operator==(const FixedString<M>& other) const
+    {
+        return this->size == other.length() && memcmp(this->characters, other.c_str(), this->size) == 0;
+    }
+
+    template <size_t M>
+    bool operator!=(const FixedString<M>& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * @file MessageField.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Field descriptors of the messagetypes
+ * @version 0.1
+ * @date 2020-04-14
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEFIELD_H__
+#define MESSAGEFIELD_H__
+
+#include <Arduino.h>
+#include <stddef.h>
+
+#include "FixedString.h"
+#include "MessageSymbol.h"
+
+/**
+ * @brief Enum class holds the kinds of a message field
+ *
+ */
+enum class FieldType : uint8_t
+{
+    Unsigned,
+    Signed,
+    Boolean,
+    Text,
+    Symbol
+};
+
+/**
+ * @brief Kind and capacity of a field from its C++ type
+ *
+ * @tparam T
+ */
+template <class T> struct MessageFieldType;
+template <> struct MessageFieldType<unsigned int> { static constexpr FieldType value = FieldType::Unsigned; static constexpr size_t capacity = 0; };
+template <> struct MessageFieldType<int> { static constexpr FieldType value = FieldType::Signed; static constexpr size_t capacity = 0; };
+template <> struct MessageFieldType<bool> { static constexpr FieldType value = FieldType::Boolean; static constexpr size_t capacity = 0; };
+template <size_t N> struct MessageFieldType<FixedString<N>> { static constexpr FieldType value = FieldType::Text; static constexpr size_t capacity = N; };
+template <> struct MessageFieldType<MessageSymbol> { static constexpr FieldType value = FieldType::Symbol; static constexpr size_t capacity = MESSAGE_SYMBOL_LENGTH; };
+
+/**
+ * @brief Describes one field of a message: its key, its kind and where it is stored
+ *
+ */
+struct MessageField
+{
+    const char* key;                            ///< key in JSON and MessagePack
+    FieldType type;                             ///< kind of the field
+    size_t offset;                              ///< offset of the member in its fields struct
+    size_t capacity;                            ///< maximum number of characters of a text field
+};
+
+/**
+ * @brief Describe a member of a fields struct, the key is the member name
+ *
+ */
+#define MESSAGE_FIELD(Fields, member) {#member,                                                   \
+                                       MessageFieldType<decltype(Fields::member)>::value,         \
+                                       offsetof(Fields, member),                                  \
+                                       MessageFieldType<decltype(Fields::member)>::capacity}
+
+/**
+ * @brief Set of fields of one message type, bit i selects the field at index i of its table
+ *
+ */
+typedef uint32_t MessageFieldMask;
+
+/**
+ * @brief Mask that selects every field
+ *
+ */
+#define MESSAGE_FIELDS_ALL ((MessageFieldMask)0xFFFFFFFF)
+
+/**
+ * @brief Number of slots of the perfect hash of a field table
+ *
+ * A table must hash its keys to distinct slots with one of the first
+ * MESSAGE_FIELD_SEEDS seeds, raise it if a table with many fields fails to
+ * compile with a call to messageFieldSeedsExhausted.
+ *
+ */
+#ifndef MESSAGE_FIELD_SLOTS
+#define MESSAGE_FIELD_SLOTS 32
+#endif
+#define MESSAGE_FIELD_SEEDS 256
+#define MESSAGE_FIELD_NO_SLOT 0xFF
+
+/**
+ * @brief Perfect hash from the keys of a field table to their index
+ *
+ */
+struct MessageFieldIndex
+{
+    uint32_t seed;                              ///< seed that separates all keys of the table
+    uint8_t slots[MESSAGE_FIELD_SLOTS];         ///< field index per slot, MESSAGE_FIELD_NO_SLOT if empty
+};
+
+/**
+ * @brief FNV-1a hash of a key, evaluated at compile time for the tables and at runtime for the input
+ *
+ * @param key
+ * @param length
+ * @param hash - seeded offset basis
+ * @return uint32_t
+ */
+constexpr uint32_t messageKeyHash(const char* key, size_t length, uint32_t hash)
+{
+    return length == 0 ? hash : messageKeyHash(key + 1, length - 1, (hash ^ (uint8_t)*key) * 16777619u);
+}
+
+constexpr size_t messageKeyLength(const char* key)
+{
+    return *key ? 1 + messageKeyLength(key + 1) : 0;
+}
+
+/**
+ * @brief Slot of a key in a table hashed with the given seed
+ *
+ * @param key
+ * @param length
+ * @param seed
+ * @return size_t
+ */
+constexpr size_t messageKeySlot(const char* key, size_t length, uint32_t seed)
+{
+    // the high bits of the hash depend on every character and on the whole seed
+    return (size_t)(((uint64_t)messageKeyHash(key, length, 2166136261u ^ (seed * 0x9E3779B9u)) * MESSAGE_FIELD_SLOTS) >> 32);
+}
+
+constexpr size_t messageFieldSlot(const MessageField* fields, size_t i, uint32_t seed)
+{
+    return messageKeySlot(fields[i].key, messageKeyLength(fields[i].key), seed);
+}
+
+/**
+ * @brief Check that field i does not share its slot with a field before it
+ *
+ */
+constexpr bool messageFieldSlotFree(const MessageField* fields, size_t i, size_t j, uint32_t seed)
+{
+    return j >= i || (messageFieldSlot(fields, j, seed) != messageFieldSlot(fields, i, seed) &&
+                      messageFieldSlotFree(fields, i, j + 1, seed));
+}
+
+constexpr bool messageFieldSeedPerfect(const MessageField* fields, size_t count, size_t i, uint32_t seed)
+{
+    return i >= count || (messageFieldSlotFree(fields, i, 0, seed) && messageFieldSeedPerfect(fields, count, i + 1, seed));
+}
+
+/**
+ * @brief Never defined, calling it in a constant expression fails the build
+ *
+ */
+uint32_t messageFieldSeedsExhausted();
+
+constexpr uint32_t messageFieldSeed(const MessageField* fields, size_t count, uint32_t seed)
+{
+    return seed >= MESSAGE_FIELD_SEEDS ? messageFieldSeedsExhausted()
+         : messageFieldSeedPerfect(fields, count, 0, seed) ? seed
+         : messageFieldSeed(fields, count, seed + 1);
+}
+
+constexpr uint8_t messageFieldInSlot(const MessageField* fields, size_t count, uint32_t seed, size_t slot, size_t i)
+{
+    return i >= count ? MESSAGE_FIELD_NO_SLOT
+         : messageFieldSlot(fields, i, seed) == slot ? (uint8_t)i
+         : messageFieldInSlot(fields, count, seed, slot, i + 1);
+}
+
+template <size_t... S> struct MessageFieldSlots {};
+template <size_t N, size_t... S> struct MessageFieldSlotRange : MessageFieldSlotRange<N - 1, N - 1, S...> {};
+template <size_t... S> struct MessageFieldSlotRange<0, S...> { typedef MessageFieldSlots<S...> type; };
+
+template <size_t... S>
+constexpr MessageFieldIndex messageFieldIndex(const MessageField* fields, size_t count, uint32_t seed, MessageFieldSlots<S...>)
+{
+    return MessageFieldIndex{seed, {messageFieldInSlot(fields, count, seed, S, 0)...}};
+}
+
+/**
+ * @brief Build the perfect hash of a field table at compile time
+ *
+ * static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+ *
+ * @tparam N
+ * @param fields
+ * @return MessageFieldIndex
+ */
+template <size_t N>
+constexpr MessageFieldIndex messageFieldIndex(const MessageField (&fields)[N])
+{
+    return messageFieldIndex(fields, N, messageFieldSeed(fields, N, 0), typename MessageFieldSlotRange<MESSAGE_FIELD_SLOTS>::type());
+}
+
+/**
+ * @brief Field descriptors of one message type in wire order
+ *
+ */
+struct MessageFieldTable
+{
+    const MessageField* fields;                 ///< first descriptor
+    size_t count;                               ///< number of descriptors
+    const MessageFieldIndex* index;             ///< perfect hash of the keys, nullptr to look them up one by one
+
+    MessageFieldTable() : fields(nullptr), count(0), index(nullptr)
+    {
+    }
+
+    template <size_t N>
+    explicit MessageFieldTable(const MessageField (&fields)[N], const MessageFieldIndex* index = nullptr) : fields(fields), count(N), index(index)
+    {
+        static_assert(N <= 8 * sizeof(MessageFieldMask), "a MessageFieldMask must cover every field");
+        static_assert(N < MESSAGE_FIELD_SLOTS, "MESSAGE_FIELD_SLOTS must exceed the number of fields");
+    }
+
+    /**
+     * @brief Index of the field with the given key
+     *
+     * One hash and one compare with the index, a linear search without.
+     *
+     * @param key - not null-terminated
+     * @param length
+     * @return size_t - count if the type has no such field
+     */
+    size_t find(const char* key, size_t length) const
+    {
+        if (this->index)
+        {
+            uint8_t i = this->index->slots[messageKeySlot(key, length, this->index->seed)];
+            return i != MESSAGE_FIELD_NO_SLOT && strncmp(this->fields[i].key, key, length) == 0 &&
+                   this->fields[i].key[length] == '\0' ? i : this->count;
+        }
+        for (size_t i = 0; i < this->count; i++)
+        {
+            if (strncmp(this->fields[i].key, key, length) == 0 && this->fields[i].key[length] == '\0')
+            {
+                return i;
+            }
+        }
+        return this->count;
+    }
+
+    /**
+     * @brief Mask of the field with the given key
+     *
+     * Combine the masks of several fields with |, e.g.
+     * SOInitMessage::Fields::table().mask("line") | ...
+     *
+     * @param key
+     * @return MessageFieldMask - zero if the type has no such field
+     */
+    MessageFieldMask mask(const char* key) const
+    {
+        size_t i = this->find(key, strlen(key));
+        return i < this->count ? (MessageFieldMask)1 << i : 0;
+    }
+};
+
+#endif
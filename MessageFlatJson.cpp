@@ -0,0 +1,325 @@
+/**
+ * @file MessageFlatJson.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Tokenizer for flat JSON objects of the messagetypes
+ * @version 0.1
+ * @date 2020-05-25
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageFlatJson.h"
+
+MessageFlatJson::MessageFlatJson(const char* input, size_t length, MessageStructuralIndex* structurals) : input(input), length(length), structurals(structurals)
+{
+}
+
+void MessageFlatJson::skipWhitespace()
+{
+    while (this->position < this->length && (this->input[this->position] == ' ' || this->input[this->position] == '\t' ||
+                                              this->input[this->position] == '\n' || this->input[this->position] == '\r'))
+    {
+        this->position++;
+    }
+}
+
+bool MessageFlatJson::scalarEnds() const
+{
+    if (this->position >= this->length)
+    {
+        return false;
+    }
+    char c = this->input[this->position];
+    return c == ',' || c == '}' || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool MessageFlatJson::readDigits(uint32_t& value, uint32_t limit)
+{
+    size_t first = this->position;
+    uint64_t number = 0;
+    while (this->position < this->length && this->input[this->position] >= '0' && this->input[this->position] <= '9')
+    {
+        number = number * 10 + (uint64_t)(this->input[this->position] - '0');
+        if (number > limit)
+        {
+            this->error = true;
+            return false;
+        }
+        this->position++;
+    }
+    // leading zeros are not JSON, fractions and exponents are not expected
+    if (this->position == first || (this->input[first] == '0' && this->position - first > 1) || !this->scalarEnds())
+    {
+        this->error = true;
+        return false;
+    }
+    value = (uint32_t)number;
+    return true;
+}
+
+void MessageFlatJson::beginObject()
+{
+    this->skipWhitespace();
+    if (this->position >= this->length || this->input[this->position] != '{')
+    {
+        this->error = true;
+        return;
+    }
+    this->position++;
+}
+
+bool MessageFlatJson::nextKey(const char*& key, size_t& keyLength)
+{
+    if (this->error)
+    {
+        return false;
+    }
+    this->skipWhitespace();
+    if (this->position >= this->length)
+    {
+        this->error = true;
+        return false;
+    }
+    if (this->input[this->position] == '}')
+    {
+        this->position++;
+        return false;
+    }
+    // members after the first are preceded by a comma
+    if (this->members > 0)
+    {
+        if (this->input[this->position] != ',')
+        {
+            this->error = true;
+            return false;
+        }
+        this->position++;
+        this->skipWhitespace();
+    }
+    this->members++;
+
+    this->read(key, keyLength);
+    this->skipWhitespace();
+    if (this->error || this->position >= this->length || this->input[this->position] != ':')
+    {
+        this->error = true;
+        return false;
+    }
+    this->position++;
+    this->skipWhitespace();
+    return true;
+}
+
+void MessageFlatJson::endObject()
+{
+    this->skipWhitespace();
+    if (this->position != this->length)
+    {
+        this->error = true;
+    }
+}
+
+void MessageFlatJson::read(unsigned int& value)
+{
+    uint32_t number = 0;
+    if (this->readDigits(number, 0xFFFFFFFF))
+    {
+        value = number;
+    }
+}
+
+void MessageFlatJson::read(int& value)
+{
+    bool negative = this->position < this->length && this->input[this->position] == '-';
+    this->position += negative ? 1 : 0;
+    uint32_t number = 0;
+    if (this->readDigits(number, negative ? 0x80000000u : 0x7FFFFFFFu))
+    {
+        value = negative ? (int)(0u - number) : (int)number;
+    }
+}
+
+void MessageFlatJson::read(bool& value)
+{
+    size_t rest = this->length - this->position;
+    const char* literal = this->input + this->position;
+    if (rest >= 4 && memcmp(literal, "true", 4) == 0)
+    {
+        this->position += 4;
+        value = true;
+    }
+    else if (rest >= 5 && memcmp(literal, "false", 5) == 0)
+    {
+        this->position += 5;
+        value = false;
+    }
+    else
+    {
+        this->error = true;
+        return;
+    }
+    if (!this->scalarEnds())
+    {
+        this->error = true;
+    }
+}
+
+void MessageFlatJson::read(const char*& characters, size_t& length)
+{
+    if (this->position >= this->length || this->input[this->position] != '"')
+    {
+        this->error = true;
+        return;
+    }
+    size_t first = this->position + 1;
+    // escapes would need a copy, control characters are malformed
+    size_t end = this->skipString(false);
+    if (!this->error)
+    {
+        characters = this->input + first;
+        length = end - first;
+    }
+}
+
+size_t MessageFlatJson::nextStructural(size_t from)
+{
+    if (this->structurals)
+    {
+        return this->structurals->nextFrom(from);
+    }
+    while (from < this->length && !MessageStructural::isStructural(this->input[from]))
+    {
+        from++;
+    }
+    return from < this->length ? from : this->length;
+}
+
+size_t MessageFlatJson::skipString(bool escapes)
+{
+    // Colons, commas and brackets are characters of the string
+    size_t end = this->nextStructural(this->position + 1);
+    while (end < this->length && this->input[end] != '"')
+    {
+        if (!escapes && (this->input[end] == '\\' || (uint8_t)this->input[end] < 0x20))
+        {
+            break;
+        }
+        end = this->nextStructural(end + (this->input[end] == '\\' ? 2 : 1));
+    }
+    if (end >= this->length || this->input[end] != '"')
+    {
+        this->error = true;
+        return this->length;
+    }
+    this->position = end + 1;
+    return end;
+}
+
+void MessageFlatJson::readField(const MessageField& descriptor, void* data)
+{
+    void* member = static_cast<char*>(data) + descriptor.offset;
+    const char* characters = nullptr;
+    size_t length = 0;
+    switch (descriptor.type)
+    {
+    case FieldType::Unsigned:
+        this->read(*static_cast<unsigned int*>(member));
+        break;
+    case FieldType::Signed:
+        this->read(*static_cast<int*>(member));
+        break;
+    case FieldType::Boolean:
+        this->read(*static_cast<bool*>(member));
+        break;
+    case FieldType::Text:
+        this->read(characters, length);
+        if (!this->error && !FixedStringAccess::assign(member, descriptor.capacity, characters, length))
+        {
+            this->error = true;
+        }
+        break;
+    case FieldType::Symbol:
+        this->read(characters, length);
+        if (!this->error && !MessageSymbol::intern(characters, length, *static_cast<MessageSymbol*>(member)))
+        {
+            this->error = true;
+        }
+        break;
+    }
+}
+
+void MessageFlatJson::skipValue()
+{
+    if (this->position >= this->length)
+    {
+        this->error = true;
+        return;
+    }
+    char c = this->input[this->position];
+    if (c == '"')
+    {
+        // unknown strings may hold escapes, they are not copied
+        this->skipString(true);
+        return;
+    }
+    size_t rest = this->length - this->position;
+    const char* literal = this->input + this->position;
+    if (c == 't' || c == 'f' || c == 'n')
+    {
+        size_t size = c == 'f' ? 5 : 4;
+        const char* expected = c == 't' ? "true" : c == 'f' ? "false" : "null";
+        if (rest < size || memcmp(literal, expected, size) != 0)
+        {
+            this->error = true;
+            return;
+        }
+        this->position += size;
+    }
+    else
+    {
+        // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        this->position += c == '-' ? 1 : 0;
+        if (!this->skipDigits(false))
+        {
+            return;
+        }
+        if (this->position < this->length && this->input[this->position] == '.')
+        {
+            this->position++;
+            this->skipDigits(true);
+        }
+        if (this->position < this->length && (this->input[this->position] == 'e' || this->input[this->position] == 'E'))
+        {
+            this->position++;
+            if (this->position < this->length && (this->input[this->position] == '+' || this->input[this->position] == '-'))
+            {
+                this->position++;
+            }
+            this->skipDigits(true);
+        }
+    }
+    if (!this->error && !this->scalarEnds())
+    {
+        this->error = true;
+    }
+}
+
+bool MessageFlatJson::skipDigits(bool leadingZeros)
+{
+    size_t first = this->position;
+    while (this->position < this->length && this->input[this->position] >= '0' && this->input[this->position] <= '9')
+    {
+        this->position++;
+    }
+    if (this->position == first || (!leadingZeros && this->input[first] == '0' && this->position - first > 1))
+    {
+        this->error = true;
+        return false;
+    }
+    return true;
+}
+
+bool MessageFlatJson::failed() const
+{
+    return this->error;
+}
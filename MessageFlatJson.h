@@ -0,0 +1,184 @@
+/**
+ * @file MessageFlatJson.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Tokenizer for flat JSON objects of the messagetypes
+ * @version 0.1
+ * @date 2020-05-25
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEFLATJSON_H__
+#define MESSAGEFLATJSON_H__
+
+#include <Arduino.h>
+
+#include "MessageField.h"
+#include "MessageStructural.h"
+
+/**
+ * @brief Use the flat JSON fast path in Message::decode, 0 parses every payload with ArduinoJson
+ *
+ */
+#ifndef MESSAGE_FLAT_JSON
+#define MESSAGE_FLAT_JSON 1
+#endif
+
+/**
+ * @brief Cursor over a JSON object of scalars and short strings
+ *
+ * Reads the members in one pass directly from the payload, without a
+ * document and without allocation. Everything the messages never contain
+ * (nested values, escaped strings, fractions, quoted numbers) sets the
+ * error, so the caller can fall back to ArduinoJson for an exact result.
+ *
+ */
+class MessageFlatJson
+{
+private:
+
+    const char* input;                          ///< payload
+    size_t length;                              ///< number of payload bytes
+    size_t position = 0;                        ///< read position
+    size_t members = 0;                         ///< number of keys read
+    bool error = false;                         ///< input is not a flat object or malformed
+    MessageStructuralIndex* structurals;        ///< index of the payload, nullptr to scan byte by byte
+
+    /**
+     * @brief Skip JSON whitespace
+     *
+     */
+    void skipWhitespace();
+
+    /**
+     * @brief Check that a scalar ends at the read position
+     *
+     * @return true - followed by whitespace, a comma or the closing brace
+     * @return false
+     */
+    bool scalarEnds() const;
+
+    /**
+     * @brief Read an unsigned number without sign, fraction or exponent
+     *
+     * @param value
+     * @param limit - largest value accepted
+     * @return true
+     * @return false - sets the error
+     */
+    bool readDigits(uint32_t& value, uint32_t limit);
+
+    /**
+     * @brief Position of the first structural byte at or after a position
+     *
+     * @param from
+     * @return size_t - length if there is none
+     */
+    size_t nextStructural(size_t from);
+
+    /**
+     * @brief Move behind the string that starts at the read position
+     *
+     * @param escapes - skip escapes and control characters, otherwise they set the error
+     * @return size_t - position of the closing quote
+     */
+    size_t skipString(bool escapes);
+
+    /**
+     * @brief Skip the digits of a number
+     *
+     * @param leadingZeros - allowed in fractions and exponents
+     * @return true
+     * @return false - no digit, sets the error
+     */
+    bool skipDigits(bool leadingZeros);
+
+public:
+
+    /**
+     * @brief Construct a cursor over a payload
+     *
+     * Strings are found through the structural index if one is given, the
+     * result is the same.
+     *
+     * @param input
+     * @param length
+     * @param structurals - index over the same payload
+     */
+    MessageFlatJson(const char* input, size_t length, MessageStructuralIndex* structurals = nullptr);
+
+    /**
+     * @brief Read the opening brace
+     *
+     */
+    void beginObject();
+
+    /**
+     * @brief Read the key of the next member and the colon behind it
+     *
+     * @param key - not null-terminated
+     * @param keyLength
+     * @return true - a value follows
+     * @return false - the object ended or the input is malformed
+     */
+    bool nextKey(const char*& key, size_t& keyLength);
+
+    /**
+     * @brief Check that nothing but whitespace follows the object
+     *
+     */
+    void endObject();
+
+    /**
+     * @brief Read an unsigned number
+     *
+     * @param value
+     */
+    void read(unsigned int& value);
+
+    /**
+     * @brief Read a signed number
+     *
+     * @param value
+     */
+    void read(int& value);
+
+    /**
+     * @brief Read true or false
+     *
+     * @param value
+     */
+    void read(bool& value);
+
+    /**
+     * @brief Locate the characters of a string without escapes
+     *
+     * @param characters - points into the payload, not null-terminated
+     * @param length
+     */
+    void read(const char*& characters, size_t& length);
+
+    /**
+     * @brief Read a value into a field described by a descriptor
+     *
+     * @param descriptor
+     * @param data - fields struct the descriptor belongs to
+     */
+    void readField(const MessageField& descriptor, void* data);
+
+    /**
+     * @brief Skip a scalar or string value of an unknown key
+     *
+     */
+    void skipValue();
+
+    /**
+     * @brief Check if the input could not be read as a flat object
+     *
+     * @return true
+     * @return false
+     */
+    bool failed() const;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file MessageFormat.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Wire formats of the messagetypes
+ * @version 0.1
+ * @date 2020-03-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEFORMAT_H__
+#define MESSAGEFORMAT_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief First byte of a binary message
+ *
+ * 0xC1 is never used in MessagePack and can not start a JSON text or an
+ * UTF-8 character, so the format of a payload is known from its first byte.
+ *
+ */
+#define MESSAGE_BINARY_MAGIC 0xC1
+
+/**
+ * @brief First byte of a frame holding several binary or MessagePack messages
+ *
+ * The magic byte is followed by the number of messages and every message
+ * prefixed with its length, both as varints. 0xC2 is MessagePack false and,
+ * like 0xC1, can not start a JSON text.
+ *
+ */
+#define MESSAGE_BATCH_MAGIC 0xC2
+
+/**
+ * @brief Enum class holds all supported wire formats
+ *
+ * Binary layout: magic byte, then msgId, msgType, msgLength, msgConsignor and
+ * the specific fields in declaration order. Unsigned numbers are varints,
+ * signed numbers zigzag varints, booleans one byte and strings a varint
+ * length followed by the characters. Symbols are a varint of their seeded
+ * code plus one, or zero followed by the string if they were added at runtime.
+ *
+ * MsgPack is a map with the same keys as the JSON object, readable by any
+ * MessagePack tool on the host side.
+ *
+ */
+enum class WireFormat
+{
+    Json,
+    Binary,
+    MsgPack
+};
+
+/**
+ * @brief Detect the wire format of a payload from its first byte
+ *
+ * @param payload
+ * @param length
+ * @return WireFormat
+ */
+inline WireFormat detectWireFormat(const char* payload, size_t length)
+{
+    uint8_t first = length > 0 ? (uint8_t)payload[0] : 0;
+    if (first == MESSAGE_BINARY_MAGIC)
+    {
+        return WireFormat::Binary;
+    }
+    // fixmap, map 16 or map 32
+    if ((first & 0xF0) == 0x80 || first == 0xDE || first == 0xDF)
+    {
+        return WireFormat::MsgPack;
+    }
+    return WireFormat::Json;
+}
+
+/**
+ * @brief Read a big-endian MessagePack length or number
+ *
+ * @param data
+ * @param bytes - 1 to 4
+ * @return uint32_t
+ */
+inline uint32_t msgPackReadBigEndian(const uint8_t* data, size_t bytes)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/**
+ * @brief Length of a MessagePack scalar
+ *
+ * @param data - first byte of the value
+ * @param length - bytes available
+ * @param valid - set to false for maps, arrays and extension types
+ * @return size_t - bytes of the value, zero if its header is incomplete
+ */
+inline size_t msgPackScalarLength(const uint8_t* data, size_t length, bool& valid)
+{
+    uint8_t type = data[0];
+    valid = true;
+    // positive fixint, negative fixint, nil, false and true
+    if (type <= 0x7F || type >= 0xE0 || type == 0xC0 || type == 0xC2 || type == 0xC3)
+    {
+        return 1;
+    }
+    // fixstr
+    if ((type & 0xE0) == 0xA0)
+    {
+        return 1 + (type & 0x1F);
+    }
+    switch (type)
+    {
+    case 0xCC: case 0xD0:
+        return 2;
+    case 0xCD: case 0xD1:
+        return 3;
+    case 0xCA: case 0xCE: case 0xD2:
+        return 5;
+    case 0xCB: case 0xCF: case 0xD3:
+        return 9;
+    case 0xC4: case 0xD9:
+        return length < 2 ? 0 : 2 + msgPackReadBigEndian(data + 1, 1);
+    case 0xC5: case 0xDA:
+        return length < 3 ? 0 : 3 + msgPackReadBigEndian(data + 1, 2);
+    case 0xC6: case 0xDB:
+        return length < 5 ? 0 : 5 + msgPackReadBigEndian(data + 1, 4);
+    default:
+        valid = false;
+        return 0;
+    }
+}
+
+/**
+ * @brief Bytes of one encoded message, e.g. one MQTT payload
+ *
+ */
+struct MessagePayload
+{
+    const char* data;                           ///< first byte of the message
+    size_t length;                              ///< number of bytes
+};
+
+/**
+ * @brief Enum class holds the outcome of decoding one message
+ *
+ */
+enum class DecodeStatus : uint8_t
+{
+    Ok,
+    Malformed,          ///< the payload is not valid in its wire format or is truncated
+    NoMemory,           ///< the payload exceeds MESSAGE_JSON_CAPACITY
+    UnknownType,        ///< msgType is missing or not registered, no message is created
+    Invalid,            ///< a field has the wrong type or exceeds its capacity
+    WrongType           ///< msgType differs from the type of the message decoded into, it is left unchanged
+};
+
+#endif
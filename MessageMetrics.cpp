@@ -0,0 +1,296 @@
+/**
+ * @file MessageMetrics.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Counters, byte totals and latency histograms per messagetype
+ * @version 0.1
+ * @date 2020-05-11
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageMetrics.h"
+
+#include <stdio.h>
+
+//======================STORAGE==========================================================
+//=======================================================================================
+
+#if MESSAGE_METRICS
+
+/**
+ * @brief Live metrics of one message type, updated from any task
+ *
+ */
+struct LiveTypeMetrics
+{
+    std::atomic<uint32_t> decoded;
+    std::atomic<uint32_t> decodeErrors;
+    std::atomic<uint32_t> encoded;
+    std::atomic<uint32_t> encodeErrors;
+    std::atomic<uint32_t> bytesIn;
+    std::atomic<uint32_t> bytesOut;
+    std::atomic<uint32_t> decodeLatency[MESSAGE_METRICS_BUCKETS];
+    std::atomic<uint32_t> encodeLatency[MESSAGE_METRICS_BUCKETS];
+};
+
+static LiveTypeMetrics liveMetrics[Message::MESSAGE_TYPES + 1];     ///< zero-initialized, indexed by MessageType
+
+static LiveTypeMetrics& metricsOf(Message::MessageType type)
+{
+    size_t index = (size_t)type;
+    return liveMetrics[index <= Message::MESSAGE_TYPES ? index : 0];
+}
+
+/**
+ * @brief Histogram bucket of a duration
+ *
+ * @param started - timestamp from MessageMetrics::start
+ * @return size_t
+ */
+static size_t bucketOf(uint32_t started)
+{
+    uint32_t elapsed = (uint32_t)micros() - started;
+    uint32_t bound = MESSAGE_METRICS_FIRST_BUCKET;
+    size_t bucket = 0;
+    while (elapsed >= bound && bucket < MESSAGE_METRICS_BUCKETS - 1)
+    {
+        bound <<= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void increment(std::atomic<uint32_t>& counter, uint32_t value = 1)
+{
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+static uint32_t load(const std::atomic<uint32_t>& counter)
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+#endif
+
+//======================REPORT===========================================================
+//=======================================================================================
+
+/**
+ * @brief Print that counts the bytes written through it
+ *
+ */
+class CountingPrint
+{
+private:
+
+    Print& output;                              ///< destination
+    size_t written = 0;                         ///< number of bytes written
+
+public:
+
+    explicit CountingPrint(Print& output) : output(output)
+    {
+    }
+
+    void print(const char* text)
+    {
+        this->written += this->output.write((const uint8_t*)text, strlen(text));
+    }
+
+    void print(unsigned long value)
+    {
+        char digits[12];
+        snprintf(digits, sizeof(digits), "%lu", value);
+        this->print(digits);
+    }
+
+    void varint(unsigned long value)
+    {
+        uint8_t bytes[10];
+        size_t length = 0;
+        while (value >= 0x80)
+        {
+            bytes[length++] = (uint8_t)((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        bytes[length++] = (uint8_t)value;
+        this->written += this->output.write(bytes, length);
+    }
+
+    size_t length() const
+    {
+        return this->written;
+    }
+};
+
+static bool isActive(const MessageTypeMetrics& metrics)
+{
+    return metrics.decoded || metrics.decodeErrors || metrics.encoded || metrics.encodeErrors;
+}
+
+static void printHistogram(CountingPrint& output, const char* key, const uint32_t (&buckets)[MESSAGE_METRICS_BUCKETS])
+{
+    output.print(key);
+    for (size_t i = 0; i < MESSAGE_METRICS_BUCKETS; i++)
+    {
+        output.print(i ? "," : "[");
+        output.print((unsigned long)buckets[i]);
+    }
+    output.print("]");
+}
+
+//======================MessageMetrics===================================================
+//=======================================================================================
+
+#if MESSAGE_METRICS
+
+void MessageMetrics::recordDecode(Message::MessageType type, size_t bytes, bool ok, uint32_t started)
+{
+    LiveTypeMetrics& metrics = metricsOf(type);
+    increment(ok ? metrics.decoded : metrics.decodeErrors);
+    increment(metrics.bytesIn, (uint32_t)bytes);
+    increment(metrics.decodeLatency[bucketOf(started)]);
+}
+
+void MessageMetrics::recordEncode(Message::MessageType type, size_t bytes, bool ok, uint32_t started)
+{
+    LiveTypeMetrics& metrics = metricsOf(type);
+    increment(ok ? metrics.encoded : metrics.encodeErrors);
+    if (ok)
+    {
+        increment(metrics.bytesOut, (uint32_t)bytes);
+    }
+    increment(metrics.encodeLatency[bucketOf(started)]);
+}
+
+#endif
+
+void MessageMetrics::snapshot(MessageMetricsSnapshot& snapshot)
+{
+    MESSAGE_FUNCCALLln("MessageMetrics::snapshot(MessageMetricsSnapshot&)");
+    snapshot = MessageMetricsSnapshot();
+#if MESSAGE_METRICS
+    for (size_t type = 0; type <= Message::MESSAGE_TYPES; type++)
+    {
+        const LiveTypeMetrics& live = liveMetrics[type];
+        MessageTypeMetrics& metrics = snapshot.types[type];
+        metrics.decoded = load(live.decoded);
+        metrics.decodeErrors = load(live.decodeErrors);
+        metrics.encoded = load(live.encoded);
+        metrics.encodeErrors = load(live.encodeErrors);
+        metrics.bytesIn = load(live.bytesIn);
+        metrics.bytesOut = load(live.bytesOut);
+        for (size_t i = 0; i < MESSAGE_METRICS_BUCKETS; i++)
+        {
+            metrics.decodeLatency[i] = load(live.decodeLatency[i]);
+            metrics.encodeLatency[i] = load(live.encodeLatency[i]);
+        }
+    }
+#endif
+}
+
+void MessageMetrics::reset()
+{
+    MESSAGE_FUNCCALLln("MessageMetrics::reset()");
+#if MESSAGE_METRICS
+    for (LiveTypeMetrics& live : liveMetrics)
+    {
+        live.decoded.store(0, std::memory_order_relaxed);
+        live.decodeErrors.store(0, std::memory_order_relaxed);
+        live.encoded.store(0, std::memory_order_relaxed);
+        live.encodeErrors.store(0, std::memory_order_relaxed);
+        live.bytesIn.store(0, std::memory_order_relaxed);
+        live.bytesOut.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < MESSAGE_METRICS_BUCKETS; i++)
+        {
+            live.decodeLatency[i].store(0, std::memory_order_relaxed);
+            live.encodeLatency[i].store(0, std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+size_t MessageMetrics::reportJson(Print& output)
+{
+    MESSAGE_FUNCCALLln("MessageMetrics::reportJson(Print&)");
+    MessageMetricsSnapshot current;
+    snapshot(current);
+    CountingPrint writer(output);
+    writer.print("{\"buckets\":");
+    for (size_t i = 0; i < MESSAGE_METRICS_BUCKETS - 1; i++)
+    {
+        writer.print(i ? "," : "[");
+        writer.print((unsigned long)MESSAGE_METRICS_FIRST_BUCKET << i);
+    }
+    writer.print("],\"types\":[");
+    bool first = true;
+    for (size_t type = 0; type <= Message::MESSAGE_TYPES; type++)
+    {
+        const MessageTypeMetrics& metrics = current.types[type];
+        if (!isActive(metrics))
+        {
+            continue;
+        }
+        writer.print(first ? "{\"type\":" : ",{\"type\":");
+        first = false;
+        writer.print((unsigned long)type);
+        writer.print(",\"decoded\":");
+        writer.print((unsigned long)metrics.decoded);
+        writer.print(",\"decodeErrors\":");
+        writer.print((unsigned long)metrics.decodeErrors);
+        writer.print(",\"encoded\":");
+        writer.print((unsigned long)metrics.encoded);
+        writer.print(",\"encodeErrors\":");
+        writer.print((unsigned long)metrics.encodeErrors);
+        writer.print(",\"bytesIn\":");
+        writer.print((unsigned long)metrics.bytesIn);
+        writer.print(",\"bytesOut\":");
+        writer.print((unsigned long)metrics.bytesOut);
+        printHistogram(writer, ",\"decodeLatency\":", metrics.decodeLatency);
+        printHistogram(writer, ",\"encodeLatency\":", metrics.encodeLatency);
+        writer.print("}");
+    }
+    writer.print("]}");
+    return writer.length();
+}
+
+size_t MessageMetrics::reportBinary(Print& output)
+{
+    MESSAGE_FUNCCALLln("MessageMetrics::reportBinary(Print&)");
+    MessageMetricsSnapshot current;
+    snapshot(current);
+    size_t active = 0;
+    for (const MessageTypeMetrics& metrics : current.types)
+    {
+        active += isActive(metrics) ? 1 : 0;
+    }
+
+    CountingPrint writer(output);
+    writer.varint(MESSAGE_METRICS_BUCKETS);
+    writer.varint(MESSAGE_METRICS_FIRST_BUCKET);
+    writer.varint(active);
+    for (size_t type = 0; type <= Message::MESSAGE_TYPES; type++)
+    {
+        const MessageTypeMetrics& metrics = current.types[type];
+        if (!isActive(metrics))
+        {
+            continue;
+        }
+        writer.varint(type);
+        writer.varint(metrics.decoded);
+        writer.varint(metrics.decodeErrors);
+        writer.varint(metrics.encoded);
+        writer.varint(metrics.encodeErrors);
+        writer.varint(metrics.bytesIn);
+        writer.varint(metrics.bytesOut);
+        for (uint32_t count : metrics.decodeLatency)
+        {
+            writer.varint(count);
+        }
+        for (uint32_t count : metrics.encodeLatency)
+        {
+            writer.varint(count);
+        }
+    }
+    return writer.length();
+}
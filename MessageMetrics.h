@@ -0,0 +1,172 @@
+/**
+ * @file MessageMetrics.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Counters, byte totals and latency histograms per messagetype
+ * @version 0.1
+ * @date 2020-05-11
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEMETRICS_H__
+#define MESSAGEMETRICS_H__
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "Messages.h"
+
+/**
+ * @brief Record metrics in the factory and codec paths, 0 compiles them out
+ *
+ */
+#ifndef MESSAGE_METRICS
+#define MESSAGE_METRICS 1
+#endif
+
+/**
+ * @brief Number of latency buckets per histogram
+ *
+ */
+#ifndef MESSAGE_METRICS_BUCKETS
+#define MESSAGE_METRICS_BUCKETS 8
+#endif
+
+/**
+ * @brief Upper bound of the first latency bucket in microseconds
+ *
+ * Every further bucket doubles the bound, the last bucket has none.
+ * With the defaults the buckets end at 16, 32, 64, 128, 256, 512 and
+ * 1024 us.
+ *
+ */
+#ifndef MESSAGE_METRICS_FIRST_BUCKET
+#define MESSAGE_METRICS_FIRST_BUCKET 16
+#endif
+
+/**
+ * @brief Metrics of one message type
+ *
+ */
+struct MessageTypeMetrics
+{
+    uint32_t decoded = 0;                                       ///< successful decodes
+    uint32_t decodeErrors = 0;                                  ///< failed decodes, the message has msgId zero or is nullptr
+    uint32_t encoded = 0;                                       ///< successful encodes
+    uint32_t encodeErrors = 0;                                  ///< encodes into a too small buffer
+    uint32_t bytesIn = 0;                                       ///< received payload bytes, failed decodes included
+    uint32_t bytesOut = 0;                                      ///< bytes of the successful encodes
+    uint32_t decodeLatency[MESSAGE_METRICS_BUCKETS] = {};       ///< decodes per latency bucket
+    uint32_t encodeLatency[MESSAGE_METRICS_BUCKETS] = {};       ///< encodes per latency bucket
+};
+
+/**
+ * @brief Copy of all metrics at one point in time
+ *
+ */
+struct MessageMetricsSnapshot
+{
+    /**
+     * @brief Metrics indexed by MessageType
+     *
+     * Index zero (DEFAULTMESSAGETYPE) holds payloads whose type could not be
+     * read or is not registered.
+     *
+     */
+    MessageTypeMetrics types[Message::MESSAGE_TYPES + 1];
+};
+
+/**
+ * @brief Registry of the metrics of all message types
+ *
+ * Recording is a few relaxed atomic increments, so it can stay enabled on
+ * production nodes. Reports list only the types with activity.
+ *
+ */
+class MessageMetrics
+{
+public:
+
+    /**
+     * @brief Timestamp to pass to the record functions
+     *
+     * @return uint32_t - microseconds
+     */
+    static uint32_t start()
+    {
+#if MESSAGE_METRICS
+        return (uint32_t)micros();
+#else
+        return 0;
+#endif
+    }
+
+#if MESSAGE_METRICS
+    /**
+     * @brief Record one decode
+     *
+     * @param type - DEFAULTMESSAGETYPE if no message was created
+     * @param bytes - length of the payload
+     * @param ok - the message was decoded without error
+     * @param started - timestamp from start
+     */
+    static void recordDecode(Message::MessageType type, size_t bytes, bool ok, uint32_t started);
+
+    /**
+     * @brief Record one encode
+     *
+     * @param type
+     * @param bytes - length of the encoded message
+     * @param ok - the message fitted into the buffer
+     * @param started - timestamp from start
+     */
+    static void recordEncode(Message::MessageType type, size_t bytes, bool ok, uint32_t started);
+#else
+    static void recordDecode(Message::MessageType, size_t, bool, uint32_t)
+    {
+    }
+
+    static void recordEncode(Message::MessageType, size_t, bool, uint32_t)
+    {
+    }
+#endif
+
+    /**
+     * @brief Copy the current metrics
+     *
+     * @param snapshot
+     */
+    static void snapshot(MessageMetricsSnapshot& snapshot);
+
+    /**
+     * @brief Set all metrics to zero
+     *
+     */
+    static void reset();
+
+    /**
+     * @brief Write the metrics as compact JSON
+     *
+     * {"buckets":[16,...],"types":[{"type":1,"decoded":..,"decodeErrors":..,
+     * "encoded":..,"encodeErrors":..,"bytesIn":..,"bytesOut":..,
+     * "decodeLatency":[..],"encodeLatency":[..]},...]}
+     *
+     * @param output
+     * @return size_t - number of bytes written
+     */
+    static size_t reportJson(Print& output);
+
+    /**
+     * @brief Write the metrics as binary
+     *
+     * Varints: number of buckets, bound of the first bucket, number of types,
+     * then per type its MessageType, the six counters of MessageTypeMetrics
+     * and both histograms.
+     *
+     * @param output
+     * @return size_t - number of bytes written
+     */
+    static size_t reportBinary(Print& output);
+};
+
+#endif
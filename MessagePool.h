@@ -0,0 +1,269 @@
+/**
+ * @file MessagePool.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Fixed-capacity object pools for the messagetypes
+ * @version 0.1
+ * @date 2020-03-23
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEPOOL_H__
+#define MESSAGEPOOL_H__
+
+#include <Arduino.h>
+#include <atomic>
+#include <memory>
+#include <new>
+
+#include "MessageTrace.h"
+#include "Messages.h"
+
+/**
+ * @brief Number of pooled objects per message type
+ *
+ * Messages held by the application at the same time beyond this number are
+ * allocated on the heap. Can be overridden with a build flag. The default
+ * holds a full queue of MessageStreamDecoder of one type.
+ *
+ */
+#ifndef MESSAGES_POOL_SIZE
+#define MESSAGES_POOL_SIZE 4
+#endif
+
+/**
+ * @brief Fixed number of statically allocated slots for objects of type T
+ *
+ * One instance exists per slot type. acquire and release are lock-free, so
+ * slots can be released from another task than the one that acquired them.
+ *
+ * @tparam T - type stored in a slot
+ * @tparam N - number of slots
+ */
+template <class T, size_t N>
+class MessageSlots
+{
+private:
+
+    alignas(T) unsigned char storage[N][sizeof(T)];     ///< memory of the slots
+    std::atomic<bool> used[N];                          ///< slot is handed out
+
+    MessageSlots()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            this->used[i] = false;
+        }
+    }
+
+public:
+
+    /**
+     * @brief Get the slots of type T
+     *
+     * @return MessageSlots&
+     */
+    static MessageSlots& instance()
+    {
+        static MessageSlots slots;
+        return slots;
+    }
+
+    /**
+     * @brief Take a free slot
+     *
+     * @return void* - memory of the slot, nullptr if all slots are used
+     */
+    void* acquire()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            if (!this->used[i].exchange(true, std::memory_order_acquire))
+            {
+                return this->storage[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Give a slot back
+     *
+     * @param slot
+     * @return true - slot belongs to this pool
+     * @return false - slot was not acquired from this pool
+     */
+    bool release(void* slot)
+    {
+        unsigned char* memory = static_cast<unsigned char*>(slot);
+        if (memory < this->storage[0] || memory >= this->storage[0] + sizeof(this->storage))
+        {
+            return false;
+        }
+        this->used[(memory - this->storage[0]) / sizeof(T)].store(false, std::memory_order_release);
+        return true;
+    }
+};
+
+/**
+ * @brief Allocator of the shared_ptr control blocks of pooled messages
+ *
+ * The control block type is only known inside the standard library, it is
+ * taken from slots of exactly its size. The heap is used when they run out.
+ *
+ * @tparam T
+ * @tparam N
+ */
+template <class T, size_t N>
+class MessagePoolAllocator
+{
+public:
+
+    typedef T value_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef MessagePoolAllocator<U, N> other;
+    };
+
+    MessagePoolAllocator()
+    {
+    }
+
+    template <class U>
+    MessagePoolAllocator(const MessagePoolAllocator<U, N>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        void* slot = n == 1 ? MessageSlots<T, N>::instance().acquire() : nullptr;
+        return static_cast<T*>(slot ? slot : ::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        if (!MessageSlots<T, N>::instance().release(pointer))
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+    template <class U>
+    bool operator==(const MessagePoolAllocator<U, N>&) const
+    {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const MessagePoolAllocator<U, N>&) const
+    {
+        return false;
+    }
+};
+
+/**
+ * @brief Fixed-capacity pool of messages of type T
+ *
+ * The objects live in static memory and are recycled when the last handle
+ * is released. acquire resets an object to its default values before it is
+ * handed out again, so a failed or partial decode never shows the fields of
+ * a previous message.
+ *
+ * @tparam T - message class
+ * @tparam N - number of pooled objects
+ */
+template <class T, size_t N = MESSAGES_POOL_SIZE>
+class MessagePool
+{
+private:
+
+    T objects[N];                               ///< pooled messages
+    std::atomic<bool> used[N];                  ///< message is handed out
+
+    /**
+     * @brief Returns a message to the pool when its last handle is released
+     *
+     */
+    struct Recycler
+    {
+        void operator()(T* object) const
+        {
+            MessagePool::instance().release(object);
+        }
+    };
+
+    MessagePool()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            this->used[i] = false;
+        }
+    }
+
+    /**
+     * @brief Get the pool of type T
+     *
+     * @return MessagePool&
+     */
+    static MessagePool& instance()
+    {
+        static MessagePool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Give a recycled message its default values
+     *
+     * Only the registered fields and the frame are assigned, the message is
+     * not constructed again. msgType is set by the constructor of T and
+     * never changes.
+     *
+     * @param object
+     */
+    static void reset(T& object)
+    {
+        static_cast<typename T::Fields&>(object) = typename T::Fields();
+        object.msgId = 0;
+        object.msgLength = 0;
+        object.msgConsignor = Consignor::DEFUALTCONSIGNOR;
+    }
+
+    /**
+     * @brief Mark a pooled message as free
+     *
+     * @param object
+     */
+    void release(T* object)
+    {
+        this->used[object - this->objects].store(false, std::memory_order_release);
+    }
+
+public:
+
+    /**
+     * @brief Hand out a pooled message
+     *
+     * The message has its default values. Falls back to std::make_shared
+     * when all pooled messages are in use.
+     *
+     * @return std::shared_ptr<T>
+     */
+    static std::shared_ptr<T> acquire()
+    {
+        MessagePool& pool = instance();
+        for (size_t i = 0; i < N; i++)
+        {
+            if (!pool.used[i].exchange(true, std::memory_order_acquire))
+            {
+                reset(pool.objects[i]);
+                return std::shared_ptr<T>(&pool.objects[i], Recycler(), MessagePoolAllocator<T, N>());
+            }
+        }
+        MESSAGE_WARNINGln("MessagePool exhausted, increase MESSAGES_POOL_SIZE");
+        return std::make_shared<T>();
+    }
+};
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * @file MessageReader.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Decoder for the messagetypes
+ * @version 0.1
+ * @date 2020-03-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageReader.h"
+
+#include <limits.h>
+
+MessageReader::MessageReader(JsonObjectConst object) : format(WireFormat::Json), object(object)
+{
+}
+
+MessageReader::MessageReader(const uint8_t* data, size_t size) : format(WireFormat::Binary), data(data), size(size)
+{
+}
+
+JsonVariantConst MessageReader::member(const char* key) const
+{
+    return this->walked ? *this->walked : this->object[key];
+}
+
+unsigned long MessageReader::readVarint()
+{
+    unsigned long value = 0;
+    for (unsigned int shift = 0; shift < 8 * sizeof(value); shift += 7)
+    {
+        if (this->position >= this->size)
+        {
+            break;
+        }
+        uint8_t byte = this->data[this->position++];
+        // the last group must not carry bits beyond the width of an unsigned long
+        if (8 * sizeof(value) - shift < 7 && (byte & 0x7F) >> (8 * sizeof(value) - shift) != 0)
+        {
+            break;
+        }
+        value |= (unsigned long)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+    // truncated or wider than an unsigned long
+    this->error = true;
+    return 0;
+}
+
+size_t MessageReader::beginBatch()
+{
+    if (this->size == 0 || this->data[0] != MESSAGE_BATCH_MAGIC)
+    {
+        this->error = true;
+        return 0;
+    }
+    this->position = 1;
+    return this->readVarint();
+}
+
+bool MessageReader::batchItem(MessagePayload& item)
+{
+    unsigned long length = this->readVarint();
+    if (this->error || length > this->size - this->position)
+    {
+        this->error = true;
+        return false;
+    }
+    item.data = (const char*)this->data + this->position;
+    item.length = length;
+    this->position += length;
+    return true;
+}
+
+void MessageReader::beginObject()
+{
+    if (this->format == WireFormat::Binary)
+    {
+        if (this->size == 0 || this->data[0] != MESSAGE_BINARY_MAGIC)
+        {
+            this->error = true;
+        }
+        this->position = 1;
+    }
+    else if (this->object.isNull())
+    {
+        this->error = true;
+    }
+}
+
+void MessageReader::endObject()
+{
+}
+
+void MessageReader::field(const char* key, unsigned int& value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        unsigned long number = this->readVarint();
+        if (number > UINT_MAX)
+        {
+            this->error = true;
+            return;
+        }
+        value = (unsigned int)number;
+        return;
+    }
+    JsonVariantConst variant = this->member(key);
+    if (variant.is<unsigned int>())
+    {
+        value = variant.as<unsigned int>();
+        return;
+    }
+    // older firmware sends numbers as strings
+    const char* characters = variant.as<const char*>();
+    value = characters ? (unsigned int)strtoul(characters, nullptr, 10) : variant.as<unsigned int>();
+}
+
+void MessageReader::field(const char* key, int& value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        // zigzag maps the int range onto the unsigned int range
+        unsigned long zigzag = this->readVarint();
+        if (zigzag > UINT_MAX)
+        {
+            this->error = true;
+            return;
+        }
+        value = (zigzag & 1) ? -(int)(zigzag >> 1) - 1 : (int)(zigzag >> 1);
+        return;
+    }
+    JsonVariantConst variant = this->member(key);
+    if (variant.is<int>())
+    {
+        value = variant.as<int>();
+        return;
+    }
+    // older firmware sends numbers as strings
+    const char* characters = variant.as<const char*>();
+    value = characters ? (int)strtol(characters, nullptr, 10) : variant.as<int>();
+}
+
+void MessageReader::field(const char* key, bool& value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        if (this->position >= this->size)
+        {
+            this->error = true;
+            return;
+        }
+        value = this->data[this->position++] != 0;
+        return;
+    }
+    JsonVariantConst variant = this->member(key);
+    if (variant.is<bool>())
+    {
+        value = variant.as<bool>();
+        return;
+    }
+    // older firmware sends booleans as "1" and "0"
+    const char* characters = variant.as<const char*>();
+    value = characters ? (strcmp(characters, "1") == 0 || strcmp(characters, "true") == 0) : variant.as<int>() != 0;
+}
+
+bool MessageReader::readString(const char* key, const char*& characters, size_t& length)
+{
+    if (this->format == WireFormat::Json)
+    {
+        JsonVariantConst variant = this->member(key);
+        if (variant.isNull())
+        {
+            // missing members and null read as "null", like as<String>() did
+            characters = "null";
+            length = 4;
+            return true;
+        }
+        if (!variant.is<const char*>())
+        {
+            return false;
+        }
+        characters = variant.as<const char*>();
+        length = strlen(characters);
+        return true;
+    }
+
+    unsigned long size = this->readVarint();
+    if (this->error || size > this->size - this->position)
+    {
+        this->error = true;
+        return false;
+    }
+    characters = (const char*)this->data + this->position;
+    length = size;
+    this->position += size;
+    return true;
+}
+
+void MessageReader::field(const char* key, String& value)
+{
+    if (this->format == WireFormat::Json && !this->member(key).is<const char*>())
+    {
+        // numbers and other values are converted like before
+        value = this->member(key).as<String>();
+        return;
+    }
+
+    const char* characters = nullptr;
+    size_t length = 0;
+    if (!this->readString(key, characters, length))
+    {
+        return;
+    }
+    if (this->format == WireFormat::Json)
+    {
+        // assign the characters so a recycled String keeps its buffer
+        value = characters;
+        return;
+    }
+
+    // the input is not null-terminated, append it in small terminated chunks
+    char chunk[33];
+    value = "";
+    value.reserve((unsigned int)length);
+    for (size_t copied = 0; copied < length;)
+    {
+        size_t part = length - copied < sizeof(chunk) - 1 ? length - copied : sizeof(chunk) - 1;
+        memcpy(chunk, characters + copied, part);
+        chunk[part] = '\0';
+        value.concat(chunk);
+        copied += part;
+    }
+}
+
+void MessageReader::field(const char* key, MessageSymbol& value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        // seeded symbols are sent as code + 1, others as zero and the string
+        unsigned long code = this->readVarint();
+        if (this->error)
+        {
+            return;
+        }
+        if (code != 0)
+        {
+            if (!MessageSymbol::fromSeededCode(code - 1, value))
+            {
+                this->error = true;
+            }
+            return;
+        }
+    }
+
+    const char* characters = nullptr;
+    size_t length = 0;
+    if (!this->readString(key, characters, length) || !MessageSymbol::intern(characters, length, value))
+    {
+        this->error = true;
+    }
+}
+
+void MessageReader::readText(const char* key, void* string, size_t capacity)
+{
+    const char* characters = nullptr;
+    size_t length = 0;
+    if (!this->readString(key, characters, length) || !FixedStringAccess::assign(string, capacity, characters, length))
+    {
+        this->error = true;
+    }
+}
+
+void MessageReader::project(MessageFieldMask mask)
+{
+    this->projection = mask;
+}
+
+void MessageReader::fields(const MessageFieldTable& table, void* data)
+{
+    // Walk the members once, missing fields stay null like a failed lookup and
+    // the first of duplicate keys wins like it does for object[key]
+    JsonVariantConst values[8 * sizeof(MessageFieldMask)];
+    MessageFieldMask seen = 0;
+    bool walk = this->format == WireFormat::Json;
+    if (walk)
+    {
+        for (JsonPairConst pair : this->object)
+        {
+            JsonString key = pair.key();
+            size_t i = table.find(key.c_str(), key.size());
+            if (i < table.count && !(seen & ((MessageFieldMask)1 << i)))
+            {
+                seen |= (MessageFieldMask)1 << i;
+                values[i] = pair.value();
+            }
+        }
+    }
+
+    char* base = static_cast<char*>(data);
+    for (size_t i = 0; i < table.count; i++)
+    {
+        const MessageField& descriptor = table.fields[i];
+        this->walked = walk ? &values[i] : nullptr;
+        if (!(this->projection & ((MessageFieldMask)1 << i)))
+        {
+            // binary fields have no key, their bytes are skipped to reach the next one
+            if (this->format == WireFormat::Binary && !this->error)
+            {
+                this->skipField(descriptor);
+            }
+            continue;
+        }
+        void* member = base + descriptor.offset;
+        switch (descriptor.type)
+        {
+        case FieldType::Unsigned:
+            this->field(descriptor.key, *static_cast<unsigned int*>(member));
+            break;
+        case FieldType::Signed:
+            this->field(descriptor.key, *static_cast<int*>(member));
+            break;
+        case FieldType::Boolean:
+            this->field(descriptor.key, *static_cast<bool*>(member));
+            break;
+        case FieldType::Text:
+            this->readText(descriptor.key, member, descriptor.capacity);
+            break;
+        case FieldType::Symbol:
+            this->field(descriptor.key, *static_cast<MessageSymbol*>(member));
+            break;
+        }
+    }
+    this->walked = nullptr;
+}
+
+void MessageReader::skipField(const MessageField& descriptor)
+{
+    const char* characters = nullptr;
+    size_t length = 0;
+    switch (descriptor.type)
+    {
+    case FieldType::Unsigned:
+    case FieldType::Signed:
+        this->readVarint();
+        break;
+    case FieldType::Boolean:
+        if (this->position >= this->size)
+        {
+            this->error = true;
+            break;
+        }
+        this->position++;
+        break;
+    case FieldType::Text:
+        this->readString(descriptor.key, characters, length);
+        break;
+    case FieldType::Symbol:
+        // runtime symbols follow code zero as a string
+        if (this->readVarint() == 0 && !this->error)
+        {
+            this->readString(descriptor.key, characters, length);
+        }
+        break;
+    }
+}
+
+void MessageReader::skipFields(const MessageFieldTable& table)
+{
+    for (size_t i = 0; i < table.count && !this->error; i++)
+    {
+        this->skipField(table.fields[i]);
+    }
+}
+
+size_t MessageReader::consumed() const
+{
+    return this->position;
+}
+
+bool MessageReader::failed() const
+{
+    return this->error;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file MessageReader.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Decoder for the messagetypes
+ * @version 0.1
+ * @date 2020-03-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEREADER_H__
+#define MESSAGEREADER_H__
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "FixedString.h"
+#include "MessageField.h"
+#include "MessageFormat.h"
+#include "MessageSymbol.h"
+
+/**
+ * @brief Reads the fields of a message from a JSON object or a binary payload
+ *
+ * The message classes list their fields once in readFields, the reader
+ * takes them from the matching format. JSON fields are looked up by key,
+ * binary fields are read in order.
+ *
+ */
+class MessageReader
+{
+private:
+
+    WireFormat format;                          ///< format of the input
+    JsonObjectConst object;                     ///< input object in JSON format
+    const uint8_t* data = nullptr;              ///< input bytes in binary format
+    size_t size = 0;                            ///< number of input bytes
+    size_t position = 0;                        ///< read position in the input bytes
+    bool error = false;                         ///< input was malformed or truncated
+    MessageFieldMask projection = MESSAGE_FIELDS_ALL;   ///< fields read by fields, the others are skipped
+    const JsonVariantConst* walked = nullptr;   ///< value of the field being read, found by the object walk of fields
+
+    /**
+     * @brief Read a binary varint
+     *
+     * @return unsigned long
+     */
+    unsigned long readVarint();
+
+    /**
+     * @brief Value of a JSON member
+     *
+     * @param key
+     * @return JsonVariantConst - the walked value while fields reads, else a lookup of the key
+     */
+    JsonVariantConst member(const char* key) const;
+
+    /**
+     * @brief Locate the characters of a string field
+     *
+     * A missing or null JSON member reads as "null", like as<String>().
+     *
+     * @param key
+     * @param characters - not null-terminated in binary format
+     * @param length
+     * @return true
+     * @return false - the field is missing, malformed or not a string
+     */
+    bool readString(const char* key, const char*& characters, size_t& length);
+
+    /**
+     * @brief Read a text field into a FixedString of the given capacity
+     *
+     * @param key
+     * @param string - address of a FixedString<capacity>
+     * @param capacity
+     */
+    void readText(const char* key, void* string, size_t capacity);
+
+    /**
+     * @brief Skip one binary field without storing it
+     *
+     * @param descriptor
+     */
+    void skipField(const MessageField& descriptor);
+
+public:
+
+    /**
+     * @brief Construct a reader of a deserialized JSON object
+     *
+     * @param object
+     */
+    explicit MessageReader(JsonObjectConst object);
+
+    /**
+     * @brief Construct a reader of a binary payload
+     *
+     * @param data
+     * @param size
+     */
+    MessageReader(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Begin a binary or MsgPack frame of several messages
+     *
+     * @return size_t - number of messages announced by the frame
+     */
+    size_t beginBatch();
+
+    /**
+     * @brief Slice the next message out of a frame of several messages
+     *
+     * @param item - set to the bytes of the message
+     * @return true
+     * @return false - the frame is truncated
+     */
+    bool batchItem(MessagePayload& item);
+
+    /**
+     * @brief Begin the message object
+     *
+     */
+    void beginObject();
+
+    /**
+     * @brief End the message object
+     *
+     */
+    void endObject();
+
+    /**
+     * @brief Read an unsigned number field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, unsigned int& value);
+
+    /**
+     * @brief Read a signed number field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, int& value);
+
+    /**
+     * @brief Read a boolean field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, bool& value);
+
+    /**
+     * @brief Read a string field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, String& value);
+
+    /**
+     * @brief Read a symbol field, unknown strings are interned
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, MessageSymbol& value);
+
+    /**
+     * @brief Read a string field into a fixed-capacity string
+     *
+     * Values longer than the capacity make the read fail.
+     *
+     * @tparam N
+     * @param key
+     * @param value
+     */
+    template <size_t N>
+    void field(const char* key, FixedString<N>& value)
+    {
+        this->readText(key, &value, N);
+    }
+
+    /**
+     * @brief Restrict fields to a subset of the table
+     *
+     * Fields outside the mask keep their values and may be missing from a
+     * JSON or MessagePack input.
+     *
+     * @param mask
+     */
+    void project(MessageFieldMask mask);
+
+    /**
+     * @brief Read all fields described by a field table
+     *
+     * Text values longer than the capacity of their field make the read fail.
+     * Only the fields of the projection are stored. A JSON object is walked
+     * once and every key is dispatched through the perfect hash of the table,
+     * instead of one linear lookup per field.
+     *
+     * @param table
+     * @param data - fields struct the table describes
+     */
+    void fields(const MessageFieldTable& table, void* data);
+
+    /**
+     * @brief Skip all binary fields described by a field table without storing them
+     *
+     * Used to find the end of a binary message, fails if the input is truncated.
+     *
+     * @param table
+     */
+    void skipFields(const MessageFieldTable& table);
+
+    /**
+     * @brief Number of binary input bytes read so far
+     *
+     * @return size_t
+     */
+    size_t consumed() const;
+
+    /**
+     * @brief Check if the input was malformed or truncated
+     *
+     * @return true
+     * @return false
+     */
+    bool failed() const;
+};
+
+#endif
@@ -0,0 +1,269 @@
+/**
+ * @file MessageRegistry.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Compile-time registry of the messagetypes
+ * @version 0.1
+ * @date 2020-04-06
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEREGISTRY_H__
+#define MESSAGEREGISTRY_H__
+
+#include <new>
+#include <type_traits>
+
+#include "MessagePool.h"
+#include "Messages.h"
+
+/**
+ * @brief Checks at compile time that the message classes follow the MessageType order
+ *
+ * @tparam Types
+ */
+template <class... Types>
+struct MessageTypeOrder;
+
+template <>
+struct MessageTypeOrder<>
+{
+    static constexpr bool check(size_t)
+    {
+        return true;
+    }
+};
+
+template <class T, class... Rest>
+struct MessageTypeOrder<T, Rest...>
+{
+    static constexpr bool check(size_t index)
+    {
+        return (size_t)T::TYPE == index && MessageTypeOrder<Rest...>::check(index + 1);
+    }
+};
+
+/**
+ * @brief Size of the largest fields struct at compile time
+ *
+ * @tparam Fields
+ */
+template <class... Fields>
+struct MessageFieldsSize;
+
+template <>
+struct MessageFieldsSize<>
+{
+    static constexpr size_t value = 0;
+};
+
+template <class T, class... Rest>
+struct MessageFieldsSize<T, Rest...>
+{
+    static constexpr size_t value = sizeof(T) > MessageFieldsSize<Rest...>::value ? sizeof(T) : MessageFieldsSize<Rest...>::value;
+};
+
+/**
+ * @brief Table of the message classes indexed by their MessageType
+ *
+ * Dispatch is a single array lookup. The static checks fail to compile if a
+ * message type is missing or out of order.
+ *
+ * @tparam Types - message classes in MessageType order, starting at Package
+ */
+template <class... Types>
+class MessageRegistry
+{
+private:
+
+    static_assert(sizeof...(Types) == Message::MESSAGE_TYPES,
+                  "every MessageType needs exactly one message class in the registry");
+    static_assert(MessageTypeOrder<Types...>::check(1),
+                  "message classes must be registered in MessageType order");
+
+    typedef std::shared_ptr<Message> (*Creator)();
+    typedef MessageFieldTable (*FieldLister)();
+    typedef void (*FieldResetter)(Message&);
+    typedef void* (*FieldLocator)(Message&);
+    typedef void* (*FieldStager)(void*);
+    typedef void (*FieldCommitter)(Message&, const void*);
+
+    /**
+     * @brief Take a message of class T from its pool
+     *
+     * @tparam T
+     * @return std::shared_ptr<Message>
+     */
+    template <class T>
+    static std::shared_ptr<Message> create()
+    {
+        return MessagePool<T>::acquire();
+    }
+
+    /**
+     * @brief Set the fields of a message of class T to their defaults
+     *
+     * @tparam T
+     * @param message
+     */
+    template <class T>
+    static void resetFields(Message& message)
+    {
+        static_cast<typename T::Fields&>(static_cast<T&>(message)) = typename T::Fields();
+    }
+
+    template <class T>
+    static void* fieldsOf(Message& message)
+    {
+        return static_cast<typename T::Fields*>(static_cast<T*>(&message));
+    }
+
+    template <class T>
+    static void* stageFields(void* staging)
+    {
+        static_assert(std::is_trivially_destructible<typename T::Fields>::value, "staged fields are never destroyed");
+        return new (staging) typename T::Fields();
+    }
+
+    template <class T>
+    static void commitFields(Message& message, const void* staging)
+    {
+        static_cast<typename T::Fields&>(static_cast<T&>(message)) = *static_cast<const typename T::Fields*>(staging);
+    }
+
+public:
+
+    /**
+     * @brief Number of bytes that hold the fields struct of any message type
+     *
+     */
+    static constexpr size_t FIELDS_SIZE = MessageFieldsSize<typename Types::Fields...>::value;
+
+    /**
+     * @brief Create an empty message of the given type
+     *
+     * @param type
+     * @return std::shared_ptr<Message> - nullptr if the type is unknown
+     */
+    static std::shared_ptr<Message> create(Message::MessageType type)
+    {
+        static const Creator creators[] = {&create<Types>...};
+        size_t index = (size_t)type;
+        if (index == 0 || index > sizeof...(Types))
+        {
+            return nullptr;
+        }
+        return creators[index - 1]();
+    }
+
+    /**
+     * @brief Field descriptors of the given type
+     *
+     * @param type
+     * @return MessageFieldTable - empty, with fields nullptr, if the type is unknown
+     */
+    static MessageFieldTable fields(Message::MessageType type)
+    {
+        static const FieldLister listers[] = {&Types::Fields::table...};
+        size_t index = (size_t)type;
+        if (index == 0 || index > sizeof...(Types))
+        {
+            return MessageFieldTable();
+        }
+        return listers[index - 1]();
+    }
+
+    /**
+     * @brief Set the specific fields of a message to their defaults
+     *
+     * A message decoded in place keeps the values of its previous use, a
+     * projected decode resets them so the fields it skips do not hold stale
+     * values.
+     *
+     * @param message - its msgType selects the class
+     */
+    static void resetFields(Message& message)
+    {
+        static const FieldResetter resetters[] = {&resetFields<Types>...};
+        size_t index = (size_t)message.msgType;
+        if (index > 0 && index <= sizeof...(Types))
+        {
+            resetters[index - 1](message);
+        }
+    }
+
+    /**
+     * @brief Address of the fields struct of a message, the base of its field table offsets
+     *
+     * @param message - its msgType selects the class
+     * @return void* - nullptr if the type is unknown
+     */
+    static void* fieldsOf(Message& message)
+    {
+        static const FieldLocator locators[] = {&fieldsOf<Types>...};
+        size_t index = (size_t)message.msgType;
+        if (index == 0 || index > sizeof...(Types))
+        {
+            return nullptr;
+        }
+        return locators[index - 1](message);
+    }
+
+    /**
+     * @brief Construct the default fields of a type in caller memory
+     *
+     * Lets a decode read into a copy and overwrite a message only when the
+     * whole payload was read.
+     *
+     * @param type
+     * @param staging - FIELDS_SIZE bytes, aligned like std::max_align_t
+     * @return void* - base of the field table offsets, nullptr if the type is unknown
+     */
+    static void* stageFields(Message::MessageType type, void* staging)
+    {
+        static const FieldStager stagers[] = {&stageFields<Types>...};
+        size_t index = (size_t)type;
+        if (index == 0 || index > sizeof...(Types))
+        {
+            return nullptr;
+        }
+        return stagers[index - 1](staging);
+    }
+
+    /**
+     * @brief Copy fields built by stageFields into a message
+     *
+     * @param message - its msgType selects the class
+     * @param staging
+     */
+    static void commitFields(Message& message, const void* staging)
+    {
+        static const FieldCommitter committers[] = {&commitFields<Types>...};
+        size_t index = (size_t)message.msgType;
+        if (index > 0 && index <= sizeof...(Types))
+        {
+            committers[index - 1](message, staging);
+        }
+    }
+};
+
+/**
+ * @brief All message classes, add new message types here
+ *
+ */
+typedef MessageRegistry<PackageMessage,
+                        ErrorMessage,
+                        SBAvailableMessage,
+                        SBPositionMessage,
+                        SBStateMessage,
+                        SBToSVHandshakeMessage,
+                        SVAvailableMessage,
+                        SVPositionMessage,
+                        SVStateMessage,
+                        SBToSOHandshakeMessage,
+                        SOPositionMessage,
+                        SOStateMessage,
+                        SOInitMessage,
+                        BufferMessage> RegisteredMessages;
+
+#endif
@@ -0,0 +1,544 @@
+/**
+ * @file MessageStream.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Incremental decoder for messages arriving in chunks
+ * @version 0.1
+ * @date 2020-04-27
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageStream.h"
+#include "MessageRegistry.h"
+
+//======================FRAMING==========================================================
+//=======================================================================================
+
+/**
+ * @brief Check if a byte may stand between two messages
+ *
+ * @param c
+ * @return true - whitespace or part of a JSON array of messages
+ * @return false
+ */
+static bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == '[' || c == ']';
+}
+
+/**
+ * @brief Read a varint that may be cut off by the end of the input
+ *
+ * @param data
+ * @param length
+ * @param value
+ * @param valid - set to false if the varint is longer than an unsigned long
+ * @return size_t - bytes of the varint, zero if it continues after the input
+ */
+static size_t readVarint(const uint8_t* data, size_t length, unsigned long& value, bool& valid)
+{
+    value = 0;
+    valid = true;
+    for (size_t i = 0; 7 * i < 8 * sizeof(value); i++)
+    {
+        if (i >= length)
+        {
+            return 0;
+        }
+        value |= (unsigned long)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+            return i + 1;
+        }
+    }
+    valid = false;
+    return 0;
+}
+
+//======================MessageStreamDecoder=============================================
+//=======================================================================================
+
+MessageStreamDecoder::MessageStreamDecoder()
+{
+    MESSAGE_FUNCCALLln("MessageStreamDecoder::MessageStreamDecoder()");
+}
+
+MessageStreamDecoder::Scan MessageStreamDecoder::findJsonEnd(const char* message, size_t length, size_t& end)
+{
+    // Continue where the previous chunk ended, every byte is scanned once
+    for (size_t i = this->scanned; i < length; i++)
+    {
+        char c = message[i];
+        if (this->inString)
+        {
+            if (this->escaped)
+            {
+                this->escaped = false;
+            }
+            else if (c == '\\')
+            {
+                this->escaped = true;
+            }
+            else if (c == '"')
+            {
+                this->inString = false;
+            }
+        }
+        else if (c == '"')
+        {
+            this->inString = true;
+        }
+        else if (c == '{')
+        {
+            this->depth++;
+        }
+        else if (c == '}' && --this->depth == 0)
+        {
+            end = i + 1;
+            return Scan::Complete;
+        }
+    }
+    this->scanned = length;
+    return Scan::Incomplete;
+}
+
+MessageStreamDecoder::Scan MessageStreamDecoder::findEnd(const char* message, size_t length, size_t& end)
+{
+    switch (this->state)
+    {
+    case State::Json:
+        return this->findJsonEnd(message, length, end);
+    case State::Binary:
+        {
+            // The frame tells the type, its field table tells where the message ends
+            MessageReader reader((const uint8_t*)message, length);
+            unsigned int header = 0;
+            unsigned int type = 0;
+            reader.beginObject();
+            reader.field("msgId", header);
+            reader.field("msgType", type);
+            reader.field("msgLength", header);
+            reader.field("msgConsignor", header);
+            if (reader.failed())
+            {
+                return Scan::Incomplete;
+            }
+            MessageFieldTable table = RegisteredMessages::fields((Message::MessageType)type);
+            if (!table.fields)
+            {
+                return Scan::Invalid;
+            }
+            reader.skipFields(table);
+            if (reader.failed())
+            {
+                return Scan::Incomplete;
+            }
+            end = reader.consumed();
+            return Scan::Complete;
+        }
+    case State::MsgPack:
+        {
+            const uint8_t* data = (const uint8_t*)message;
+            size_t entries = 0;
+            size_t position = 0;
+            if ((data[0] & 0xF0) == 0x80)
+            {
+                entries = data[0] & 0x0F;
+                position = 1;
+            }
+            else
+            {
+                size_t bytes = data[0] == 0xDE ? 2 : 4;
+                if (length < 1 + bytes)
+                {
+                    return Scan::Incomplete;
+                }
+                entries = msgPackReadBigEndian(data + 1, bytes);
+                position = 1 + bytes;
+            }
+            // keys and values of the map, messages hold no nested values
+            for (size_t i = 0; i < 2 * entries; i++)
+            {
+                if (position >= length)
+                {
+                    return Scan::Incomplete;
+                }
+                bool valid = true;
+                size_t value = msgPackScalarLength(data + position, length - position, valid);
+                if (!valid)
+                {
+                    return Scan::Invalid;
+                }
+                if (value == 0 || value > length - position)
+                {
+                    return Scan::Incomplete;
+                }
+                position += value;
+            }
+            end = position;
+            return Scan::Complete;
+        }
+    case State::Idle:
+        break;
+    }
+    return Scan::Invalid;
+}
+
+void MessageStreamDecoder::beginSkip()
+{
+    // JSON is tracked again from the first brace, the others from their first value
+    this->skipping = true;
+    this->scanned = 0;
+    this->depth = 0;
+    this->inString = false;
+    this->escaped = false;
+    this->skipBytes = this->state == State::Binary ? 1 : 0;
+    this->skipValues = this->state == State::Binary ? 4 : 1;
+    this->skipField = 0;
+    this->skipLength = false;
+    this->skipType = Message::MessageType::DEFAULTMESSAGETYPE;
+}
+
+MessageStreamDecoder::Scan MessageStreamDecoder::skip(const char* input, size_t length, size_t& used)
+{
+    if (this->state == State::Json)
+    {
+        size_t end = 0;
+        Scan scan = this->findJsonEnd(input, length, end);
+        this->scanned = 0;
+        used = scan == Scan::Complete ? end : length;
+        return scan;
+    }
+
+    used = 0;
+    while (true)
+    {
+        size_t part = this->skipBytes < length - used ? this->skipBytes : length - used;
+        used += part;
+        this->skipBytes -= part;
+        if (this->skipBytes > 0 || (this->skipValues > 0 && used == length))
+        {
+            return Scan::Incomplete;
+        }
+        if (this->skipValues == 0)
+        {
+            return Scan::Complete;
+        }
+        Scan scan = this->skipValue((const uint8_t*)input + used, length - used);
+        if (scan != Scan::Complete)
+        {
+            return scan;
+        }
+    }
+}
+
+MessageStreamDecoder::Scan MessageStreamDecoder::skipValue(const uint8_t* data, size_t length)
+{
+    bool valid = true;
+    if (this->state == State::MsgPack)
+    {
+        if (this->skipField == 0)
+        {
+            // the map header tells the number of keys and values
+            size_t bytes = (data[0] & 0xF0) == 0x80 ? 0 : data[0] == 0xDE ? 2 : 4;
+            if (length < 1 + bytes)
+            {
+                return Scan::Incomplete;
+            }
+            this->skipValues += 2 * (bytes == 0 ? (size_t)(data[0] & 0x0F) : (size_t)msgPackReadBigEndian(data + 1, bytes));
+            this->skipBytes = 1 + bytes;
+        }
+        else
+        {
+            size_t value = msgPackScalarLength(data, length, valid);
+            if (!valid)
+            {
+                return Scan::Invalid;
+            }
+            if (value == 0)
+            {
+                return Scan::Incomplete;
+            }
+            this->skipBytes = value;
+        }
+        this->skipField++;
+        this->skipValues--;
+        return Scan::Complete;
+    }
+
+    // The frame comes first, then the fields of the type it names
+    const MessageField* field = nullptr;
+    if (!this->skipLength && this->skipField >= 4)
+    {
+        field = RegisteredMessages::fields(this->skipType).fields + (this->skipField - 4);
+    }
+    unsigned long value = 0;
+    if (field && field->type == FieldType::Boolean)
+    {
+        this->skipBytes = 1;
+    }
+    else
+    {
+        size_t size = readVarint(data, length, value, valid);
+        if (!valid)
+        {
+            return Scan::Invalid;
+        }
+        if (size == 0)
+        {
+            return Scan::Incomplete;
+        }
+        this->skipBytes = size;
+    }
+
+    this->skipValues--;
+    if (this->skipLength || (field && field->type == FieldType::Text))
+    {
+        this->skipBytes += value;
+        this->skipField += this->skipLength ? 0 : 1;
+        this->skipLength = false;
+        return Scan::Complete;
+    }
+    if (field && field->type == FieldType::Symbol && value == 0)
+    {
+        // runtime symbols follow code zero as a string
+        this->skipLength = true;
+        this->skipValues++;
+    }
+    else if (this->skipField == 1)
+    {
+        this->skipType = (Message::MessageType)value;
+        MessageFieldTable table = RegisteredMessages::fields(this->skipType);
+        if (!table.fields)
+        {
+            return Scan::Invalid;
+        }
+        this->skipValues += table.count;
+    }
+    this->skipField++;
+    return Scan::Complete;
+}
+
+size_t MessageStreamDecoder::process(const char* input, size_t length, JsonDocument& document)
+{
+    size_t position = 0;
+    while (position < length && this->queued < MESSAGE_STREAM_QUEUE_SIZE)
+    {
+        if (this->skipping)
+        {
+            size_t used = 0;
+            Scan scan = this->skip(input + position, length - position, used);
+            position += used;
+            if (scan == Scan::Incomplete)
+            {
+                break;
+            }
+            if (scan == Scan::Invalid)
+            {
+                MESSAGE_WARNINGln("Stream message malformed, resynchronizing");
+            }
+            this->restart();
+            continue;
+        }
+
+        if (this->state == State::Idle)
+        {
+            char c = input[position];
+            if (isSeparator(c))
+            {
+                position++;
+                continue;
+            }
+            WireFormat format = detectWireFormat(input + position, length - position);
+            if (format == WireFormat::Binary)
+            {
+                this->state = State::Binary;
+            }
+            else if (format == WireFormat::MsgPack)
+            {
+                this->state = State::MsgPack;
+            }
+            else if (c == '{')
+            {
+                this->state = State::Json;
+            }
+            else
+            {
+                MESSAGE_WARNINGln("Skipping byte outside of a message");
+                position++;
+                continue;
+            }
+        }
+
+        size_t end = 0;
+        Scan scan = this->findEnd(input + position, length - position, end);
+        if (scan == Scan::Incomplete)
+        {
+            break;
+        }
+        if (scan == Scan::Complete)
+        {
+            this->emit(input + position, end, document);
+            position += end;
+        }
+        else
+        {
+            // Drop the first byte and look for the next message behind it
+            MESSAGE_WARNINGln("Stream message malformed");
+            this->reject(DecodeStatus::Malformed);
+            position++;
+        }
+        this->restart();
+    }
+    return position;
+}
+
+void MessageStreamDecoder::emit(const char* message, size_t length, JsonDocument& document)
+{
+    size_t index = (this->head + this->queued) % MESSAGE_STREAM_QUEUE_SIZE;
+    this->queue[index] = Message::decode(message, length, document, this->statuses[index]);
+    this->queued++;
+}
+
+void MessageStreamDecoder::reject(DecodeStatus status)
+{
+    size_t index = (this->head + this->queued) % MESSAGE_STREAM_QUEUE_SIZE;
+    this->queue[index] = nullptr;
+    this->statuses[index] = status;
+    this->queued++;
+}
+
+void MessageStreamDecoder::processBuffer(JsonDocument& document)
+{
+    while (true)
+    {
+        size_t used = this->process(this->buffer, this->buffered, document);
+        memmove(this->buffer, this->buffer + used, this->buffered - used);
+        this->buffered -= used;
+        if (this->buffered < MESSAGE_STREAM_BUFFER_SIZE || this->queued == MESSAGE_STREAM_QUEUE_SIZE)
+        {
+            return;
+        }
+        // The rest of the message is discarded by the next process
+        MESSAGE_WARNINGln("Stream message exceeds MESSAGE_STREAM_BUFFER_SIZE");
+        this->reject(DecodeStatus::NoMemory);
+        this->beginSkip();
+    }
+}
+
+void MessageStreamDecoder::restart()
+{
+    this->state = State::Idle;
+    this->scanned = 0;
+    this->depth = 0;
+    this->inString = false;
+    this->escaped = false;
+    this->skipping = false;
+}
+
+size_t MessageStreamDecoder::feed(const char* data, size_t length)
+{
+    MESSAGE_FUNCCALLln("MessageStreamDecoder::feed(const char*, size_t)");
+    // One document for all messages of the chunk
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    size_t consumed = 0;
+    while (consumed < length && this->queued < MESSAGE_STREAM_QUEUE_SIZE)
+    {
+        if (this->buffered > 0)
+        {
+            // Complete the pending message in the buffer
+            size_t part = MESSAGE_STREAM_BUFFER_SIZE - this->buffered;
+            if (part > length - consumed)
+            {
+                part = length - consumed;
+            }
+            memcpy(this->buffer + this->buffered, data + consumed, part);
+            this->buffered += part;
+            consumed += part;
+            this->processBuffer(document);
+            continue;
+        }
+
+        // Decode whole messages in place, keep only the beginning of the last one
+        consumed += this->process(data + consumed, length - consumed, document);
+        if (consumed < length && this->queued < MESSAGE_STREAM_QUEUE_SIZE)
+        {
+            size_t rest = length - consumed;
+            if (rest >= MESSAGE_STREAM_BUFFER_SIZE)
+            {
+                // The rest of the message is discarded by the next process
+                MESSAGE_WARNINGln("Stream message exceeds MESSAGE_STREAM_BUFFER_SIZE");
+                this->reject(DecodeStatus::NoMemory);
+                this->beginSkip();
+                continue;
+            }
+            memcpy(this->buffer, data + consumed, rest);
+            this->buffered = rest;
+            consumed = length;
+        }
+    }
+    return consumed;
+}
+
+size_t MessageStreamDecoder::poll(Stream& input)
+{
+    MESSAGE_FUNCCALLln("MessageStreamDecoder::poll(Stream&)");
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    size_t retVal = 0;
+    // Messages left in the buffer by a full queue come first
+    this->processBuffer(document);
+    while (this->queued < MESSAGE_STREAM_QUEUE_SIZE && input.available() > 0)
+    {
+        size_t part = MESSAGE_STREAM_BUFFER_SIZE - this->buffered;
+        if (part > (size_t)input.available())
+        {
+            part = (size_t)input.available();
+        }
+        part = input.readBytes(this->buffer + this->buffered, part);
+        if (part == 0)
+        {
+            break;
+        }
+        this->buffered += part;
+        retVal += part;
+        this->processBuffer(document);
+    }
+    return retVal;
+}
+
+size_t MessageStreamDecoder::available() const
+{
+    return this->queued;
+}
+
+std::shared_ptr<Message> MessageStreamDecoder::read(DecodeStatus* status)
+{
+    MESSAGE_FUNCCALLln("MessageStreamDecoder::read(DecodeStatus*)");
+    if (this->queued == 0)
+    {
+        return nullptr;
+    }
+    // Release the queue entry so a pooled message is recycled once the caller drops it
+    std::shared_ptr<Message> retVal = std::move(this->queue[this->head]);
+    this->queue[this->head] = nullptr;
+    if (status)
+    {
+        *status = this->statuses[this->head];
+    }
+    this->head = (this->head + 1) % MESSAGE_STREAM_QUEUE_SIZE;
+    this->queued--;
+    return retVal;
+}
+
+void MessageStreamDecoder::reset()
+{
+    MESSAGE_FUNCCALLln("MessageStreamDecoder::reset()");
+    this->restart();
+    this->buffered = 0;
+    for (size_t i = 0; i < MESSAGE_STREAM_QUEUE_SIZE; i++)
+    {
+        this->queue[i] = nullptr;
+    }
+    this->head = 0;
+    this->queued = 0;
+}
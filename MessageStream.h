@@ -0,0 +1,243 @@
+/**
+ * @file MessageStream.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Incremental decoder for messages arriving in chunks
+ * @version 0.1
+ * @date 2020-04-27
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGESTREAM_H__
+#define MESSAGESTREAM_H__
+
+#include <Arduino.h>
+
+#include "Messages.h"
+
+/**
+ * @brief Number of bytes kept for a message that is split across chunks
+ *
+ * Must hold the longest encoded message, messages that do not fit are
+ * dropped and reported with DecodeStatus::NoMemory. The rest of a dropped
+ * message is discarded up to its end before the next message is looked for.
+ *
+ */
+#ifndef MESSAGE_STREAM_BUFFER_SIZE
+#define MESSAGE_STREAM_BUFFER_SIZE 512
+#endif
+
+/**
+ * @brief Number of decoded messages waiting to be read
+ *
+ */
+#ifndef MESSAGE_STREAM_QUEUE_SIZE
+#define MESSAGE_STREAM_QUEUE_SIZE 4
+#endif
+
+/**
+ * @brief Resumable decoder for chunked input from a Stream or a TCP read loop
+ *
+ * Messages in any wire format may follow each other without separators.
+ * JSON objects end at their closing brace, which is tracked across chunks,
+ * binary messages after their last field and MessagePack maps after their
+ * last value. Whitespace, commas and brackets between messages are skipped,
+ * so a JSON array of messages can be streamed as well.
+ *
+ * A message that lies completely within one chunk is decoded directly from
+ * it. Only the beginning of a message that continues in the next chunk is
+ * copied into the internal buffer. A message too long for the buffer is
+ * read to its end without keeping its bytes, so its contents are never
+ * taken for the start of another message.
+ *
+ */
+class MessageStreamDecoder
+{
+private:
+
+    /**
+     * @brief Enum class holds what the decoder is currently reading
+     *
+     */
+    enum class State : uint8_t
+    {
+        Idle,
+        Json,
+        Binary,
+        MsgPack
+    };
+
+    /**
+     * @brief Enum class holds how far a message could be found in the input
+     *
+     */
+    enum class Scan : uint8_t
+    {
+        Complete,
+        Incomplete,
+        Invalid
+    };
+
+    State state = State::Idle;                              ///< format of the pending message
+    char buffer[MESSAGE_STREAM_BUFFER_SIZE];                ///< beginning of the pending message
+    size_t buffered = 0;                                    ///< number of bytes in the buffer
+    size_t scanned = 0;                                     ///< bytes of a pending JSON message already scanned
+    size_t depth = 0;                                       ///< nesting depth of a pending JSON message
+    bool inString = false;                                  ///< scan is inside a JSON string
+    bool escaped = false;                                   ///< previous JSON string character was a backslash
+    bool skipping = false;                                  ///< discarding the rest of a message that was too long
+    size_t skipBytes = 0;                                   ///< bytes of the skipped message to discard before its next value
+    size_t skipValues = 0;                                  ///< values of a skipped binary or MessagePack message still to read
+    size_t skipField = 0;                                   ///< values of a skipped binary or MessagePack message read so far
+    bool skipLength = false;                                ///< next value of a skipped binary message is a string length
+    Message::MessageType skipType = Message::MessageType::DEFAULTMESSAGETYPE;  ///< type of a skipped binary message
+    std::shared_ptr<Message> queue[MESSAGE_STREAM_QUEUE_SIZE];  ///< decoded messages
+    DecodeStatus statuses[MESSAGE_STREAM_QUEUE_SIZE];       ///< outcome of the decoded messages
+    size_t head = 0;                                        ///< index of the next message to read
+    size_t queued = 0;                                      ///< number of messages to read
+
+    /**
+     * @brief Find the end of the pending message
+     *
+     * @param message - first byte of the message
+     * @param length - bytes available
+     * @param end - set to the length of the message if it is complete
+     * @return Scan
+     */
+    Scan findEnd(const char* message, size_t length, size_t& end);
+
+    /**
+     * @brief Continue the brace tracking of a JSON message
+     *
+     * @param message
+     * @param length
+     * @param end
+     * @return Scan
+     */
+    Scan findJsonEnd(const char* message, size_t length, size_t& end);
+
+    /**
+     * @brief Start discarding the pending message from its first byte
+     *
+     */
+    void beginSkip();
+
+    /**
+     * @brief Discard the pending message up to its end
+     *
+     * @param input - continues the bytes discarded so far
+     * @param length
+     * @param used - set to the number of bytes discarded
+     * @return Scan - Incomplete if the message continues after the input
+     */
+    Scan skip(const char* input, size_t length, size_t& used);
+
+    /**
+     * @brief Read the next value of a skipped binary or MessagePack message
+     *
+     * Sets skipBytes to the bytes of the value that are not read yet.
+     *
+     * @param data
+     * @param length - at least one
+     * @return Scan - Incomplete if the input ends within the length of the value
+     */
+    Scan skipValue(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Decode messages from the front of the input and queue them
+     *
+     * @param input
+     * @param length
+     * @param document - parse arena for the messages of this call
+     * @return size_t - bytes consumed, the rest starts an incomplete message
+     *                  or did not fit into the queue
+     */
+    size_t process(const char* input, size_t length, JsonDocument& document);
+
+    /**
+     * @brief Decode the bytes of a complete message and queue the result
+     *
+     * @param message
+     * @param length
+     * @param document
+     */
+    void emit(const char* message, size_t length, JsonDocument& document);
+
+    /**
+     * @brief Queue a failed message without decoding it
+     *
+     * @param status
+     */
+    void reject(DecodeStatus status);
+
+    /**
+     * @brief Decode what is complete in the buffer and move the rest to its front
+     *
+     * @param document
+     */
+    void processBuffer(JsonDocument& document);
+
+    /**
+     * @brief Forget the pending message
+     *
+     */
+    void restart();
+
+public:
+
+    /**
+     * @brief Construct an empty decoder
+     *
+     */
+    MessageStreamDecoder();
+
+    /**
+     * @brief Decode a chunk of input
+     *
+     * Stops early if the queue is full, feed the remaining bytes again after
+     * reading messages.
+     *
+     * @param data
+     * @param length
+     * @return size_t - number of bytes consumed
+     */
+    size_t feed(const char* data, size_t length);
+
+    /**
+     * @brief Decode the bytes available in a Stream without blocking
+     *
+     * Bytes are read straight into the internal buffer while the queue has
+     * room, so no input is lost. Call it regularly, messages held back by a
+     * full queue are decoded on the next call even without new input.
+     *
+     * @param input
+     * @return size_t - number of bytes read
+     */
+    size_t poll(Stream& input);
+
+    /**
+     * @brief Number of decoded messages ready to read
+     *
+     * @return size_t
+     */
+    size_t available() const;
+
+    /**
+     * @brief Take the oldest decoded message
+     *
+     * Failed messages are returned like translateJsonToStruct does, nullptr
+     * for an unknown type or an overlong message and msgId zero otherwise.
+     *
+     * @param status - set to the outcome of the decode, may be nullptr
+     * @return std::shared_ptr<Message> - nullptr if no message is available
+     */
+    std::shared_ptr<Message> read(DecodeStatus* status = nullptr);
+
+    /**
+     * @brief Drop the pending input and all decoded messages
+     *
+     */
+    void reset();
+};
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * @file MessageStructural.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Structural index of JSON payloads with SIMD backends for host gateways
+ * @version 0.1
+ * @date 2020-05-29
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageStructural.h"
+
+#include <atomic>
+
+#if MESSAGE_STRUCTURAL_SIMD
+#include <immintrin.h>
+#endif
+
+#include "MessageTrace.h"
+
+static_assert(MESSAGE_STRUCTURAL_CAPACITY >= 32, "a window must hold the positions of one AVX2 block");
+
+//======================SCALAR===========================================================
+//=======================================================================================
+
+static size_t scanScalar(const char* input, size_t from, size_t length, uint32_t* positions, size_t capacity, size_t& count)
+{
+    count = 0;
+    for (size_t i = from; i < length; i++)
+    {
+        if (MessageStructural::isStructural(input[i]))
+        {
+            if (count == capacity)
+            {
+                return i;
+            }
+            positions[count++] = (uint32_t)i;
+        }
+    }
+    return length;
+}
+
+//======================SIMD=============================================================
+//=======================================================================================
+
+#if MESSAGE_STRUCTURAL_SIMD
+
+/**
+ * @brief Append the positions of the set bits of a block mask
+ *
+ * @return true
+ * @return false - the window is full, nothing was appended
+ */
+static bool appendBlock(uint32_t mask, size_t block, uint32_t* positions, size_t capacity, size_t& count)
+{
+    if (count + (size_t)__builtin_popcount(mask) > capacity)
+    {
+        return false;
+    }
+    while (mask)
+    {
+        positions[count++] = (uint32_t)(block + (size_t)__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Index the bytes after the last full block like the scalar backend
+ *
+ */
+static size_t scanTail(const char* input, size_t from, size_t length, uint32_t* positions, size_t capacity, size_t& count)
+{
+    size_t tail = 0;
+    size_t end = scanScalar(input, from, length, positions + count, capacity - count, tail);
+    count += tail;
+    return end;
+}
+
+__attribute__((target("sse2")))
+static size_t scanSse2(const char* input, size_t from, size_t length, uint32_t* positions, size_t capacity, size_t& count)
+{
+    count = 0;
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i brace = _mm_set1_epi8('{');
+    const __m128i closingBrace = _mm_set1_epi8('}');
+    const __m128i bracket = _mm_set1_epi8('[');
+    const __m128i closingBracket = _mm_set1_epi8(']');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    size_t block = from;
+    for (; block + 16 <= length; block += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(input + block));
+        __m128i found = _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash));
+        found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+        found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(bytes, brace), _mm_cmpeq_epi8(bytes, closingBrace)));
+        found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(bytes, bracket), _mm_cmpeq_epi8(bytes, closingBracket)));
+        // unsigned bytes up to 0x1F are unchanged by the maximum with 0x1F
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(_mm_max_epu8(bytes, control), control));
+        if (!appendBlock((uint32_t)_mm_movemask_epi8(found), block, positions, capacity, count))
+        {
+            return block;
+        }
+    }
+    return scanTail(input, block, length, positions, capacity, count);
+}
+
+__attribute__((target("avx2")))
+static size_t scanAvx2(const char* input, size_t from, size_t length, uint32_t* positions, size_t capacity, size_t& count)
+{
+    count = 0;
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i brace = _mm256_set1_epi8('{');
+    const __m256i closingBrace = _mm256_set1_epi8('}');
+    const __m256i bracket = _mm256_set1_epi8('[');
+    const __m256i closingBracket = _mm256_set1_epi8(']');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t block = from;
+    for (; block + 32 <= length; block += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(input + block));
+        __m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote), _mm256_cmpeq_epi8(bytes, backslash));
+        found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, colon), _mm256_cmpeq_epi8(bytes, comma)));
+        found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, brace), _mm256_cmpeq_epi8(bytes, closingBrace)));
+        found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, bracket), _mm256_cmpeq_epi8(bytes, closingBracket)));
+        found = _mm256_or_si256(found, _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, control), control));
+        if (!appendBlock((uint32_t)_mm256_movemask_epi8(found), block, positions, capacity, count))
+        {
+            return block;
+        }
+    }
+    return scanTail(input, block, length, positions, capacity, count);
+}
+
+#endif
+
+//======================MessageStructural================================================
+//=======================================================================================
+
+static std::atomic<uint8_t> selectedBackend(0xFF);                  ///< StructuralBackend, 0xFF until detected
+
+static MessageStructural::Scan scanOf(StructuralBackend backend)
+{
+    switch (backend)
+    {
+#if MESSAGE_STRUCTURAL_SIMD
+    case StructuralBackend::Avx2:
+        return scanAvx2;
+    case StructuralBackend::Sse2:
+        return scanSse2;
+#endif
+    default:
+        return scanScalar;
+    }
+}
+
+bool MessageStructural::supports(StructuralBackend backend)
+{
+    MESSAGE_FUNCCALLln("MessageStructural::supports(StructuralBackend)");
+#if MESSAGE_STRUCTURAL_SIMD
+    __builtin_cpu_init();
+    switch (backend)
+    {
+    case StructuralBackend::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case StructuralBackend::Sse2:
+        return __builtin_cpu_supports("sse2");
+    default:
+        return true;
+    }
+#else
+    return backend == StructuralBackend::Scalar;
+#endif
+}
+
+StructuralBackend MessageStructural::backend()
+{
+    MESSAGE_FUNCCALLln("MessageStructural::backend()");
+    uint8_t selected = selectedBackend.load(std::memory_order_relaxed);
+    if (selected == 0xFF)
+    {
+        // Detected once, concurrent first calls detect the same backend. AVX2
+        // is only chosen by select, messages are too short to amortize its blocks
+        StructuralBackend detected = supports(StructuralBackend::Sse2) ? StructuralBackend::Sse2 : StructuralBackend::Scalar;
+        selected = (uint8_t)detected;
+        uint8_t expected = 0xFF;
+        selectedBackend.compare_exchange_strong(expected, selected, std::memory_order_relaxed);
+        selected = selectedBackend.load(std::memory_order_relaxed);
+    }
+    return (StructuralBackend)selected;
+}
+
+bool MessageStructural::select(StructuralBackend backend)
+{
+    MESSAGE_FUNCCALLln("MessageStructural::select(StructuralBackend)");
+    if (!supports(backend))
+    {
+        return false;
+    }
+    selectedBackend.store((uint8_t)backend, std::memory_order_relaxed);
+    return true;
+}
+
+MessageStructural::Scan MessageStructural::scanner()
+{
+    MESSAGE_FUNCCALLln("MessageStructural::scanner()");
+    return scanOf(backend());
+}
+
+//======================MessageStructuralIndex===========================================
+//=======================================================================================
+
+MessageStructuralIndex::MessageStructuralIndex(const char* input, size_t length) : input(input), length(length), scan(MessageStructural::scanner())
+{
+}
+
+void MessageStructuralIndex::fill(size_t start)
+{
+    this->from = start;
+    this->next = 0;
+    this->scanned = this->scan(this->input, start, this->length, this->positions, MESSAGE_STRUCTURAL_CAPACITY, this->count);
+}
+
+size_t MessageStructuralIndex::nextFrom(size_t position)
+{
+    if (position < this->from)
+    {
+        this->fill(position);
+    }
+    while (true)
+    {
+        while (this->next < this->count && this->positions[this->next] < position)
+        {
+            this->next++;
+        }
+        if (this->next < this->count)
+        {
+            return this->positions[this->next];
+        }
+        if (this->scanned >= this->length || position >= this->length)
+        {
+            return this->length;
+        }
+        // Every structural byte before the end of the window has been passed
+        this->fill(position > this->scanned ? position : this->scanned);
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file MessageStructural.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Structural index of JSON payloads with SIMD backends for host gateways
+ * @version 0.1
+ * @date 2020-05-29
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGESTRUCTURAL_H__
+#define MESSAGESTRUCTURAL_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief Locate strings and objects through the structural index, 0 scans them byte by byte
+ *
+ * Enabled on hosts, where a gateway decodes the traffic of the whole fleet.
+ * The boards scan byte by byte.
+ *
+ */
+#ifndef MESSAGE_STRUCTURAL_INDEX
+#ifdef ARDUINO
+#define MESSAGE_STRUCTURAL_INDEX 0
+#else
+#define MESSAGE_STRUCTURAL_INDEX 1
+#endif
+#endif
+
+/**
+ * @brief Compile the SSE2 and AVX2 backends, only on x86 hosts
+ *
+ */
+#if !defined(ARDUINO) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MESSAGE_STRUCTURAL_SIMD 1
+#else
+#define MESSAGE_STRUCTURAL_SIMD 0
+#endif
+
+/**
+ * @brief Number of structural positions indexed at once
+ *
+ * Longer input is indexed in windows, the window after the last position
+ * is scanned when it is reached.
+ *
+ */
+#ifndef MESSAGE_STRUCTURAL_CAPACITY
+#define MESSAGE_STRUCTURAL_CAPACITY 64
+#endif
+
+/**
+ * @brief Enum class holds the implementations of the structural scan
+ *
+ */
+enum class StructuralBackend : uint8_t
+{
+    Scalar,                                     ///< one byte per step, always available
+    Sse2,                                       ///< 16 bytes per step
+    Avx2                                        ///< 32 bytes per step
+};
+
+/**
+ * @brief Selection of the structural scan backend
+ *
+ * SSE2 is used if the CPU supports it, detected on first use. AVX2 is
+ * slower on payloads of a few hundred bytes and only used when selected.
+ * All backends index the same positions, select forces one for comparison.
+ *
+ */
+class MessageStructural
+{
+public:
+
+    /**
+     * @brief Function that indexes the structural bytes of input[from, length)
+     *
+     * @return size_t - end of the indexed range, every structural byte before it is in positions
+     */
+    typedef size_t (*Scan)(const char* input, size_t from, size_t length, uint32_t* positions, size_t capacity, size_t& count);
+
+    /**
+     * @brief Get the backend in use
+     *
+     * @return StructuralBackend
+     */
+    static StructuralBackend backend();
+
+    /**
+     * @brief Check if the CPU supports a backend
+     *
+     * @param backend
+     * @return true
+     * @return false
+     */
+    static bool supports(StructuralBackend backend);
+
+    /**
+     * @brief Use a backend for all further scans
+     *
+     * @param backend
+     * @return true
+     * @return false - not supported, the backend in use is kept
+     */
+    static bool select(StructuralBackend backend);
+
+    /**
+     * @brief Get the scan function of the backend in use
+     *
+     * @return Scan
+     */
+    static Scan scanner();
+
+    /**
+     * @brief Check if a byte is structural
+     *
+     * Quotes, backslashes, colons, commas, braces, brackets and control
+     * characters, the last reject unescaped line breaks in strings.
+     *
+     * @param c
+     * @return true
+     * @return false
+     */
+    static bool isStructural(char c)
+    {
+        return c == '"' || c == '\\' || c == ':' || c == ',' || c == '{' || c == '}' || c == '[' || c == ']' || (uint8_t)c < 0x20;
+    }
+};
+
+/**
+ * @brief Positions of the structural bytes of one payload
+ *
+ * Lives on the stack of a decode and is filled window by window as the
+ * reader moves forward.
+ *
+ */
+class MessageStructuralIndex
+{
+private:
+
+    const char* input;                                  ///< payload
+    size_t length;                                      ///< number of payload bytes
+    uint32_t positions[MESSAGE_STRUCTURAL_CAPACITY];    ///< structural positions of the window
+    size_t count = 0;                                   ///< number of positions in the window
+    size_t next = 0;                                    ///< first position not yet passed
+    size_t from = 0;                                    ///< start of the window
+    size_t scanned = 0;                                 ///< end of the window
+    MessageStructural::Scan scan;                       ///< backend
+
+    /**
+     * @brief Index the window that starts at a position
+     *
+     * @param start
+     */
+    void fill(size_t start);
+
+public:
+
+    /**
+     * @brief Construct an empty index over a payload
+     *
+     * @param input
+     * @param length
+     */
+    MessageStructuralIndex(const char* input, size_t length);
+
+    /**
+     * @brief Position of the first structural byte at or after a position
+     *
+     * @param position
+     * @return size_t - length if there is none
+     */
+    size_t nextFrom(size_t position);
+};
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * @file MessageSymbol.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Interned strings for the closed vocabularies of the messagetypes
+ * @version 0.1
+ * @date 2020-04-20
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageSymbol.h"
+
+#include <atomic>
+
+#include "MessageField.h"
+#include "MessageTrace.h"
+
+//======================SEEDED===========================================================
+//=======================================================================================
+
+/**
+ * @brief Symbols known at compile time, their index is their code on every device
+ *
+ */
+static const char* const SEEDED_SYMBOLS[] = {"", "-1", "null", MESSAGE_SYMBOLS};
+static constexpr size_t SEEDED_COUNT = sizeof(SEEDED_SYMBOLS) / sizeof(SEEDED_SYMBOLS[0]);
+
+static_assert(MESSAGE_SYMBOL_CAPACITY > 0, "the runtime symbol table needs at least one entry");
+static_assert(SEEDED_COUNT + MESSAGE_SYMBOL_CAPACITY < 0xFFFF, "symbol codes must fit into 16 bits");
+
+/**
+ * @brief Smallest power of two with at least twice as many slots as seeded symbols
+ *
+ * @param slots
+ * @return size_t
+ */
+static constexpr size_t seededSlots(size_t slots = 1)
+{
+    return slots >= 2 * SEEDED_COUNT ? slots : seededSlots(2 * slots);
+}
+
+static constexpr size_t SEEDED_SLOTS = seededSlots();
+
+/**
+ * @brief Hash of a symbol, the FNV-1a of the field keys
+ *
+ * @param name
+ * @param length
+ * @return uint32_t
+ */
+static uint32_t symbolHash(const char* name, size_t length)
+{
+    return messageKeyHash(name, length, 2166136261u);
+}
+
+static bool sameSymbol(const char* candidate, const char* name, size_t length)
+{
+    return strncmp(candidate, name, length) == 0 && candidate[length] == '\0';
+}
+
+/**
+ * @brief Open-addressed hash index over the seeded symbols
+ *
+ */
+struct SeededIndex
+{
+    uint16_t slots[SEEDED_SLOTS];               ///< code + 1 per slot, zero if empty
+
+    SeededIndex()
+    {
+        memset(this->slots, 0, sizeof(this->slots));
+        for (size_t code = 0; code < SEEDED_COUNT; code++)
+        {
+            size_t slot = symbolHash(SEEDED_SYMBOLS[code], strlen(SEEDED_SYMBOLS[code])) & (SEEDED_SLOTS - 1);
+            while (this->slots[slot] != 0)
+            {
+                slot = (slot + 1) & (SEEDED_SLOTS - 1);
+            }
+            this->slots[slot] = (uint16_t)(code + 1);
+        }
+    }
+};
+
+static bool findSeeded(const char* name, size_t length, uint32_t hash, size_t& code)
+{
+    // Built once on first use, the index is read-only afterwards
+    static const SeededIndex index;
+    for (size_t slot = hash & (SEEDED_SLOTS - 1); index.slots[slot] != 0; slot = (slot + 1) & (SEEDED_SLOTS - 1))
+    {
+        if (sameSymbol(SEEDED_SYMBOLS[index.slots[slot] - 1], name, length))
+        {
+            code = index.slots[slot] - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+//======================INTERNED=========================================================
+//=======================================================================================
+
+/**
+ * @brief States of an entry of the runtime table, an entry never goes back
+ *
+ */
+static const uint8_t ENTRY_EMPTY = 0;
+static const uint8_t ENTRY_WRITING = 1;
+static const uint8_t ENTRY_READY = 2;
+
+/**
+ * @brief String that got a code at runtime
+ *
+ */
+struct InternedSymbol
+{
+    std::atomic<uint8_t> state;                 ///< ENTRY_EMPTY, ENTRY_WRITING or ENTRY_READY
+    uint8_t length;                             ///< number of characters
+    char text[MESSAGE_SYMBOL_LENGTH + 1];       ///< characters, written before the entry is ready
+};
+
+/**
+ * @brief Runtime table, the code of entry i is SEEDED_COUNT + i
+ *
+ */
+static InternedSymbol INTERNED[MESSAGE_SYMBOL_CAPACITY];
+
+/**
+ * @brief Find or add a string in the runtime table
+ *
+ * Lock-free: a task claims an empty entry with a compare-and-swap, writes
+ * the string and then marks it ready. Entries are never removed, so a
+ * string is always found on its probe sequence before the first entry that
+ * is not ready.
+ *
+ * @param name
+ * @param length
+ * @param hash
+ * @param code - set to the code of the string
+ * @return true
+ * @return false - the table is full or an entry on the probe sequence is being written
+ */
+static bool findInterned(const char* name, size_t length, uint32_t hash, size_t& code)
+{
+    for (size_t probe = 0; probe < MESSAGE_SYMBOL_CAPACITY; probe++)
+    {
+        size_t slot = (hash + probe) % MESSAGE_SYMBOL_CAPACITY;
+        InternedSymbol& entry = INTERNED[slot];
+        uint8_t state = entry.state.load(std::memory_order_acquire);
+        if (state == ENTRY_EMPTY && entry.state.compare_exchange_strong(state, ENTRY_WRITING, std::memory_order_acquire))
+        {
+            memcpy(entry.text, name, length);
+            entry.text[length] = '\0';
+            entry.length = (uint8_t)length;
+            entry.state.store(ENTRY_READY, std::memory_order_release);
+            code = SEEDED_COUNT + slot;
+            return true;
+        }
+        if (state != ENTRY_READY)
+        {
+            // another task is writing this entry, it may be the same string
+            return false;
+        }
+        if (entry.length == length && memcmp(entry.text, name, length) == 0)
+        {
+            code = SEEDED_COUNT + slot;
+            return true;
+        }
+    }
+    return false;
+}
+
+//======================MessageSymbol====================================================
+//=======================================================================================
+
+MessageSymbol::MessageSymbol(const char* name)
+{
+    *this = name;
+}
+
+MessageSymbol& MessageSymbol::operator=(const char* name)
+{
+    if (!intern(name, strlen(name), *this))
+    {
+        MESSAGE_WARNINGln("Symbol too long, increase MESSAGE_SYMBOL_LENGTH");
+        *this = MessageSymbol();
+    }
+    return *this;
+}
+
+MessageSymbol& MessageSymbol::operator=(const String& name)
+{
+    if (!intern(name.c_str(), name.length(), *this))
+    {
+        MESSAGE_WARNINGln("Symbol too long, increase MESSAGE_SYMBOL_LENGTH");
+        *this = MessageSymbol();
+    }
+    return *this;
+}
+
+bool MessageSymbol::intern(const char* name, size_t length, MessageSymbol& symbol)
+{
+    if (length > MESSAGE_SYMBOL_LENGTH || memchr(name, '\0', length) != nullptr)
+    {
+        return false;
+    }
+
+    size_t code = 0;
+    uint32_t hash = symbolHash(name, length);
+    if (findSeeded(name, length, hash, code) || findInterned(name, length, hash, code))
+    {
+        symbol.setCode(code);
+        return true;
+    }
+    symbol.size = (uint8_t)length;
+    memcpy(symbol.text, name, length);
+    symbol.text[length] = '\0';
+    return true;
+}
+
+bool MessageSymbol::fromSeededCode(unsigned long code, MessageSymbol& symbol)
+{
+    if (code >= SEEDED_COUNT)
+    {
+        return false;
+    }
+    symbol.setCode(code);
+    return true;
+}
+
+size_t MessageSymbol::seededCount()
+{
+    return SEEDED_COUNT;
+}
+
+const char* MessageSymbol::c_str() const
+{
+    if (!this->interned())
+    {
+        return this->text;
+    }
+    size_t code = this->id();
+    return code < SEEDED_COUNT ? SEEDED_SYMBOLS[code] : INTERNED[code - SEEDED_COUNT].text;
+}
+
+size_t MessageSymbol::length() const
+{
+    if (!this->interned())
+    {
+        return this->size;
+    }
+    size_t code = this->id();
+    return code < SEEDED_COUNT ? strlen(SEEDED_SYMBOLS[code]) : INTERNED[code - SEEDED_COUNT].length;
+}
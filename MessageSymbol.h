@@ -0,0 +1,252 @@
+/**
+ * @file MessageSymbol.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Interned strings for the closed vocabularies of the messagetypes
+ * @version 0.1
+ * @date 2020-04-20
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGESYMBOL_H__
+#define MESSAGESYMBOL_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief Vocabulary of the plant: states, sectors, cargos and regions
+ *
+ * Seeded by default through MESSAGE_SYMBOLS, so these strings have the same
+ * code on every device.
+ *
+ */
+#define MESSAGE_PLANT_SYMBOLS \
+    "idle", "ready", "busy", "waiting", "loading", "unloading", "handover", "full", "empty", "error", \
+    "sector1", "sector2", "sector3", "sector4", \
+    "package", "pallet", \
+    "north", "east", "south", "west"
+
+/**
+ * @brief Symbols known at compile time, as comma-separated string literals
+ *
+ * Defaults to the plant vocabulary. Extend it with a build flag, e.g.
+ * -D 'MESSAGE_SYMBOLS=MESSAGE_PLANT_SYMBOLS,"sector5"', or replace it. All
+ * devices must use the same list, because the binary format sends these
+ * symbols as codes. New entries go to the end to keep the existing codes.
+ *
+ */
+#ifndef MESSAGE_SYMBOLS
+#define MESSAGE_SYMBOLS MESSAGE_PLANT_SYMBOLS
+#endif
+
+/**
+ * @brief Maximum number of characters of a symbol
+ *
+ */
+#ifndef MESSAGE_SYMBOL_LENGTH
+#define MESSAGE_SYMBOL_LENGTH 24
+#endif
+
+/**
+ * @brief Number of strings that get a code at runtime
+ *
+ * Strings that are not seeded are added to a fixed table the first time
+ * they are seen. Once it is full, new strings are kept inline in the symbol.
+ * Each entry takes MESSAGE_SYMBOL_LENGTH + 3 bytes of static memory.
+ *
+ */
+#ifndef MESSAGE_SYMBOL_CAPACITY
+#define MESSAGE_SYMBOL_CAPACITY 32
+#endif
+
+/**
+ * @brief Small integer code of a string, or the string itself
+ *
+ * Seeded strings and strings interned at runtime are stored as their code,
+ * so comparing two of them is an integer compare. The runtime table is
+ * bounded and lock-free: a string that finds it full, or finds a slot on its
+ * way still being written by another task, is kept inline in the symbol and
+ * compared as a string. The string form stays available through c_str for
+ * logging and for the JSON and MessagePack formats.
+ *
+ */
+class MessageSymbol
+{
+private:
+
+    static constexpr uint8_t CODED = 0xFF;                      ///< size of a symbol that is stored as its code
+
+    static_assert(MESSAGE_SYMBOL_LENGTH < CODED, "the size of an inline symbol must fit below CODED");
+
+    uint8_t size;                                               ///< number of inline characters or CODED
+    union
+    {
+        uint8_t code[2];                                        ///< code of a coded symbol, little endian
+        char text[MESSAGE_SYMBOL_LENGTH + 1];                   ///< characters of an inline symbol
+    };
+
+    /**
+     * @brief Refer to a string by its code
+     *
+     * @param value
+     */
+    void setCode(size_t value)
+    {
+        this->size = CODED;
+        this->code[0] = (uint8_t)value;
+        this->code[1] = (uint8_t)(value >> 8);
+    }
+
+public:
+
+    /**
+     * @brief Construct the empty symbol
+     *
+     */
+    MessageSymbol()
+    {
+        this->setCode(0);
+    }
+
+    /**
+     * @brief Construct a symbol from a string, see operator=
+     *
+     * @param name
+     */
+    MessageSymbol(const char* name);
+
+    /**
+     * @brief Intern a string and refer to it
+     *
+     * Becomes the empty symbol if the string is too long.
+     *
+     * @param name
+     * @return MessageSymbol&
+     */
+    MessageSymbol& operator=(const char* name);
+
+    /**
+     * @brief Intern a string and refer to it
+     *
+     * @param name
+     * @return MessageSymbol&
+     */
+    MessageSymbol& operator=(const String& name);
+
+    /**
+     * @brief Intern a string
+     *
+     * Seeded strings get their seeded code, other strings a code of the
+     * runtime table, or are kept inline if it is full.
+     *
+     * @param name - characters, need not be null-terminated
+     * @param length
+     * @param symbol - set to the symbol of the string on success
+     * @return true
+     * @return false - the string is longer than MESSAGE_SYMBOL_LENGTH or holds a null
+     */
+    static bool intern(const char* name, size_t length, MessageSymbol& symbol);
+
+    /**
+     * @brief Refer to a seeded symbol by its code
+     *
+     * @param code
+     * @param symbol
+     * @return true
+     * @return false - code is not a seeded symbol
+     */
+    static bool fromSeededCode(unsigned long code, MessageSymbol& symbol);
+
+    /**
+     * @brief Number of symbols known at compile time
+     *
+     * @return size_t
+     */
+    static size_t seededCount();
+
+    /**
+     * @brief Code of the symbol, only meaningful for interned symbols
+     *
+     * Codes below seededCount are the same on every device, the others are
+     * only valid on this one.
+     *
+     * @return uint16_t
+     */
+    uint16_t id() const
+    {
+        return this->interned() ? (uint16_t)(this->code[0] | this->code[1] << 8) : 0xFFFF;
+    }
+
+    /**
+     * @brief Check if the symbol is stored as a code
+     *
+     * @return true
+     * @return false - the string is kept inline, the runtime table was full
+     */
+    bool interned() const
+    {
+        return this->size == CODED;
+    }
+
+    /**
+     * @brief Check if the symbol is known at compile time and has the same code on every device
+     *
+     * @return true
+     * @return false
+     */
+    bool seeded() const
+    {
+        return this->interned() && this->id() < seededCount();
+    }
+
+    /**
+     * @brief String of the symbol
+     *
+     * @return const char*
+     */
+    const char* c_str() const;
+
+    /**
+     * @brief Number of characters of the string
+     *
+     * @return size_t
+     */
+    size_t length() const;
+
+    bool operator==(const MessageSymbol& other) const
+    {
+        // every string has at most one code, but may also be kept inline once the table is full
+        if (this->interned() && other.interned())
+        {
+            return this->code[0] == other.code[0] && this->code[1] == other.code[1];
+        }
+        return this->length() == other.length() && memcmp(this->c_str(), other.c_str(), this->length()) == 0;
+    }
+
+    bool operator!=(const MessageSymbol& other) const
+    {
+        return !(*this == other);
+    }
+
+    bool operator==(const char* name) const
+    {
+        return strcmp(this->c_str(), name) == 0;
+    }
+
+    bool operator!=(const char* name) const
+    {
+        return !(*this == name);
+    }
+
+    bool operator==(const String& name) const
+    {
+        return *this == name.c_str();
+    }
+
+    bool operator!=(const String& name) const
+    {
+        return !(*this == name);
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file MessageTrace.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Tracing of the messagetypes with compile-time levels and call counters
+ * @version 0.1
+ * @date 2020-05-04
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageTrace.h"
+
+#include <stdio.h>
+
+//======================LIST=============================================================
+//=======================================================================================
+
+static MessageTraceCounter listEnd("");                                     ///< sentinel after the last counter
+static std::atomic<MessageTraceCounter*> listHead(&listEnd);                ///< counter hit last for the first time
+
+//======================MessageTraceCounter==============================================
+//=======================================================================================
+
+void MessageTraceCounter::link()
+{
+    // Push in front, several tasks may link counters at the same time
+    MessageTraceCounter* head = listHead.load(std::memory_order_relaxed);
+    do
+    {
+        this->successor.store(head, std::memory_order_relaxed);
+    } while (!listHead.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+const MessageTraceCounter* MessageTraceCounter::next() const
+{
+    const MessageTraceCounter* retVal = this->successor.load(std::memory_order_acquire);
+    return retVal == &listEnd ? nullptr : retVal;
+}
+
+const MessageTraceCounter* MessageTraceCounter::first()
+{
+    const MessageTraceCounter* retVal = listHead.load(std::memory_order_acquire);
+    return retVal == &listEnd ? nullptr : retVal;
+}
+
+void MessageTraceCounter::report(Print& output)
+{
+    char hits[16];
+    for (const MessageTraceCounter* counter = first(); counter; counter = counter->next())
+    {
+        snprintf(hits, sizeof(hits), " %lu", (unsigned long)counter->hits());
+        output.print(counter->name());
+        output.println(hits);
+    }
+}
+
+void MessageTraceCounter::reset()
+{
+    for (MessageTraceCounter* counter = listHead.load(std::memory_order_acquire); counter != &listEnd;
+         counter = counter->successor.load(std::memory_order_acquire))
+    {
+        counter->count.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * @file MessageTrace.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Tracing of the messagetypes with compile-time levels and call counters
+ * @version 0.1
+ * @date 2020-05-04
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGETRACE_H__
+#define MESSAGETRACE_H__
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "LogConfiguration.h"
+
+/**
+ * @brief Trace levels, every level includes the ones below
+ *
+ */
+#define MESSAGE_TRACE_NONE 0            ///< nothing is printed
+#define MESSAGE_TRACE_WARNINGS 1        ///< failed decodes, full pools and tables
+#define MESSAGE_TRACE_INFOS 2           ///< every parsed message
+#define MESSAGE_TRACE_CALLS 3           ///< every function call
+
+/**
+ * @brief Highest level that is printed through LogConfiguration.h
+ *
+ * Trace sites above the level compile to nothing.
+ *
+ */
+#ifndef MESSAGE_TRACE_LEVEL
+#define MESSAGE_TRACE_LEVEL MESSAGE_TRACE_WARNINGS
+#endif
+
+/**
+ * @brief Count the function calls instead of, or in addition to, printing them
+ *
+ * Every MESSAGE_FUNCCALLln site gets its own counter, see MessageTraceCounter.
+ *
+ */
+#ifndef MESSAGE_TRACE_COUNTERS
+#define MESSAGE_TRACE_COUNTERS 0
+#endif
+
+/**
+ * @brief Call counter of one trace site
+ *
+ * Counters are constant-initialized statics, so counting is one relaxed
+ * atomic increment. A counter links itself into the list of all counters
+ * on its first hit, the list ends at a sentinel so a listed counter never
+ * has a null successor.
+ *
+ */
+class MessageTraceCounter
+{
+private:
+
+    const char* label;                          ///< name of the traced function
+    std::atomic<uint32_t> count;                ///< number of calls
+    std::atomic<MessageTraceCounter*> successor;    ///< next counter in the list, nullptr until listed
+
+    /**
+     * @brief Add the counter to the list of all counters
+     *
+     */
+    void link();
+
+public:
+
+    /**
+     * @brief Construct a counter that is not yet listed
+     *
+     * @param label - string literal, it is not copied
+     */
+    constexpr explicit MessageTraceCounter(const char* label) : label(label), count(0), successor(nullptr)
+    {
+    }
+
+    /**
+     * @brief Count one call
+     *
+     */
+    void hit()
+    {
+        if (this->count.fetch_add(1, std::memory_order_relaxed) == 0 && this->successor.load(std::memory_order_acquire) == nullptr)
+        {
+            this->link();
+        }
+    }
+
+    /**
+     * @brief Name of the traced function
+     *
+     * @return const char*
+     */
+    const char* name() const
+    {
+        return this->label;
+    }
+
+    /**
+     * @brief Number of calls since the start or the last reset
+     *
+     * @return uint32_t
+     */
+    uint32_t hits() const
+    {
+        return this->count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Next counter in the list
+     *
+     * @return const MessageTraceCounter* - nullptr at the end
+     */
+    const MessageTraceCounter* next() const;
+
+    /**
+     * @brief First of all counters that were hit at least once
+     *
+     * @return const MessageTraceCounter* - nullptr if no counter was hit
+     */
+    static const MessageTraceCounter* first();
+
+    /**
+     * @brief Print one line with name and hits per counter
+     *
+     * @param output
+     */
+    static void report(Print& output);
+
+    /**
+     * @brief Set all counters to zero, they stay listed
+     *
+     */
+    static void reset();
+};
+
+#if MESSAGE_TRACE_COUNTERS
+#define MESSAGE_COUNTCALL(x)    do { static MessageTraceCounter messageTraceCounter(x); messageTraceCounter.hit(); } while (0)
+#else
+#define MESSAGE_COUNTCALL(x)    do {} while (0)
+#endif
+
+#if MESSAGE_TRACE_LEVEL >= MESSAGE_TRACE_CALLS
+#define MESSAGE_FUNCCALLln(x)   do { MESSAGE_COUNTCALL(x); DBFUNCCALLln(x); } while (0)
+#else
+#define MESSAGE_FUNCCALLln(x)   MESSAGE_COUNTCALL(x)
+#endif
+
+#if MESSAGE_TRACE_LEVEL >= MESSAGE_TRACE_INFOS
+#define MESSAGE_INFOln(x)       DBINFO2ln(x)
+#else
+#define MESSAGE_INFOln(x)       do {} while (0)
+#endif
+
+#if MESSAGE_TRACE_LEVEL >= MESSAGE_TRACE_WARNINGS
+#define MESSAGE_WARNING(x)      DBWARNING(x)
+#define MESSAGE_WARNINGln(x)    DBWARNINGln(x)
+#else
+#define MESSAGE_WARNING(x)      do {} while (0)
+#define MESSAGE_WARNINGln(x)    do {} while (0)
+#endif
+
+#endif
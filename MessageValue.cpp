@@ -0,0 +1,238 @@
+/**
+ * @file MessageValue.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Value types of the messagetypes without heap and virtual functions
+ * @version 0.1
+ * @date 2020-03-30
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageValue.h"
+
+#if __cplusplus >= 201703L
+
+#include <array>
+#include <utility>
+
+#include "MessagePool.h"
+
+//======================COPY=============================================================
+//=======================================================================================
+
+template <class To, class From>
+static void copyHeader(To& to, const From& from)
+{
+    to.msgId = from.msgId;
+    to.msgLength = from.msgLength;
+    to.msgConsignor = from.msgConsignor;
+}
+
+//======================DISPATCH=========================================================
+//=======================================================================================
+
+/**
+ * @brief Number of message types with a value type
+ *
+ */
+static constexpr size_t MESSAGE_VALUE_TYPES = std::variant_size<MessageValue>::value - 1;
+
+template <size_t... I>
+static constexpr bool valuesInOrder(std::index_sequence<I...>)
+{
+    return ((std::variant_alternative_t<I + 1, MessageValue>::Object::TYPE == (Message::MessageType)(I + 1)) && ...);
+}
+
+static_assert(valuesInOrder(std::make_index_sequence<MESSAGE_VALUE_TYPES>()),
+              "MessageValue alternatives must follow the MessageType order");
+
+template <size_t I>
+static void copyAlternative(const Message& message, MessageValue& value)
+{
+    typedef std::variant_alternative_t<I, MessageValue> Value;
+    typedef typename Value::Object Object;
+    Value& alternative = value.emplace<I>();
+    const Object& object = static_cast<const Object&>(message);
+    copyHeader(alternative, object);
+    static_cast<typename Value::Fields&>(alternative) = static_cast<const typename Object::Fields&>(object);
+}
+
+template <class Value>
+static void copyObject(typename Value::Object& object, const Value& value)
+{
+    copyHeader(object, value);
+    static_cast<typename Value::Object::Fields&>(object) = static_cast<const typename Value::Fields&>(value);
+}
+
+/**
+ * @brief Make the I-th alternative the value, the record target of decodeMessageValue
+ *
+ * @return void* - fields struct of the alternative
+ */
+template <size_t I>
+static void* emplaceAlternative(MessageValue& value)
+{
+    typedef std::variant_alternative_t<I, MessageValue> Value;
+    return static_cast<typename Value::Fields*>(&value.emplace<I>());
+}
+
+typedef void* (*MessageValueEmplacer)(MessageValue&);
+typedef void (*MessageValueCopier)(const Message&, MessageValue&);
+
+template <size_t... I>
+static constexpr std::array<MessageValueEmplacer, sizeof...(I)> makeEmplacers(std::index_sequence<I...>)
+{
+    return {{&emplaceAlternative<I + 1>...}};
+}
+
+template <size_t... I>
+static constexpr std::array<MessageValueCopier, sizeof...(I)> makeCopiers(std::index_sequence<I...>)
+{
+    return {{&copyAlternative<I + 1>...}};
+}
+
+/**
+ * @brief Emplacers and copiers indexed by message type - 1
+ *
+ */
+static constexpr std::array<MessageValueEmplacer, MESSAGE_VALUE_TYPES> VALUE_EMPLACERS = makeEmplacers(std::make_index_sequence<MESSAGE_VALUE_TYPES>());
+static constexpr std::array<MessageValueCopier, MESSAGE_VALUE_TYPES> VALUE_COPIERS = makeCopiers(std::make_index_sequence<MESSAGE_VALUE_TYPES>());
+
+/**
+ * @brief Record target that emplaces the alternative of the payload type
+ *
+ * @param type
+ * @param context - MessageValue
+ * @return void* - nullptr if the type has no alternative
+ */
+static void* valueTarget(Message::MessageType type, void* context)
+{
+    size_t index = (size_t)type;
+    if (index == 0 || index > MESSAGE_VALUE_TYPES)
+    {
+        return nullptr;
+    }
+    return VALUE_EMPLACERS[index - 1](*static_cast<MessageValue*>(context));
+}
+
+/**
+ * @brief Call a function with the frame and the fields struct of the value
+ *
+ * @return size_t - result of the function, zero for std::monostate
+ */
+template <class Function>
+static size_t withRecord(const MessageValue& value, Function function)
+{
+    return std::visit([&function](const auto& alternative) -> size_t {
+        typedef std::decay_t<decltype(alternative)> Value;
+        if constexpr (std::is_same<Value, std::monostate>::value)
+        {
+            return 0;
+        }
+        else
+        {
+            return function(static_cast<const MessageHeader&>(alternative), static_cast<const typename Value::Fields*>(&alternative));
+        }
+    }, value);
+}
+
+//======================CODEC============================================================
+//=======================================================================================
+
+MessageValue decodeMessageValue(const char* payload, size_t length)
+{
+    MESSAGE_FUNCCALLln("decodeMessageValue(const char*, size_t)");
+    // The fields are read straight into the alternative, the frame once into the header
+    MessageValue retVal;
+    MessageHeader header;
+    if (Message::decodeRecord(payload, length, header, &valueTarget, &retVal) != DecodeStatus::Ok)
+    {
+        return MessageValue();
+    }
+    std::visit([&header](auto& alternative) {
+        if constexpr (!std::is_same<std::decay_t<decltype(alternative)>, std::monostate>::value)
+        {
+            copyHeader(alternative, header);
+        }
+    }, retVal);
+    return retVal;
+}
+
+size_t encodeMessageValue(const MessageValue& value, char* buffer, size_t size, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("encodeMessageValue(const MessageValue&, char*, size_t, WireFormat)");
+    return withRecord(value, [buffer, size, format](const MessageHeader& header, const void* fields) {
+        return Message::serializeRecord(header, fields, buffer, size, format);
+    });
+}
+
+size_t encodeMessageValue(const MessageValue& value, Print& output, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("encodeMessageValue(const MessageValue&, Print&, WireFormat)");
+    return withRecord(value, [&output, format](const MessageHeader& header, const void* fields) {
+        return Message::serializeRecord(header, fields, output, format);
+    });
+}
+
+size_t measureMessageValue(const MessageValue& value, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("measureMessageValue(const MessageValue&, WireFormat)");
+    return withRecord(value, [format](const MessageHeader& header, const void* fields) {
+        return Message::measureRecord(header, fields, format);
+    });
+}
+
+void updateMessageLength(MessageValue& value)
+{
+    MESSAGE_FUNCCALLln("updateMessageLength(MessageValue&)");
+    std::visit([&value](auto& alternative) {
+        if constexpr (!std::is_same<std::decay_t<decltype(alternative)>, std::monostate>::value)
+        {
+            // msgLength is part of the message, so repeat until its digits are stable
+            unsigned int length = 0;
+            do
+            {
+                alternative.msgLength = length;
+                length = (unsigned int)measureMessageValue(value);
+            } while (length != alternative.msgLength);
+        }
+    }, value);
+}
+
+//======================ADAPTER==========================================================
+//=======================================================================================
+
+std::shared_ptr<Message> toMessage(const MessageValue& value)
+{
+    MESSAGE_FUNCCALLln("toMessage(const MessageValue&)");
+    return std::visit([](const auto& alternative) -> std::shared_ptr<Message> {
+        typedef std::decay_t<decltype(alternative)> Value;
+        if constexpr (std::is_same<Value, std::monostate>::value)
+        {
+            return nullptr;
+        }
+        else
+        {
+            typedef typename Value::Object Object;
+            std::shared_ptr<Object> object = MessagePool<Object>::acquire();
+            copyObject(*object, alternative);
+            return object;
+        }
+    }, value);
+}
+
+MessageValue toMessageValue(const Message& message)
+{
+    MESSAGE_FUNCCALLln("toMessageValue(const Message&)");
+    MessageValue retVal;
+    unsigned int type = (unsigned int)message.msgType;
+    if (type == 0 || type > MESSAGE_VALUE_TYPES)
+    {
+        MESSAGE_WARNINGln("Translation failed");
+        return retVal;
+    }
+    VALUE_COPIERS[type - 1](message, retVal);
+    return retVal;
+}
+
+#endif
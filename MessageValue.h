@@ -0,0 +1,284 @@
+/**
+ * @file MessageValue.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Value types of the messagetypes without heap and virtual functions
+ * @version 0.1
+ * @date 2020-03-30
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEVALUE_H__
+#define MESSAGEVALUE_H__
+
+#include "Messages.h"
+
+// std::variant needs C++17, the class hierarchy stays available without it
+#if __cplusplus >= 201703L
+
+#include <variant>
+
+/**
+ * @brief Value type of the PackageMessage class
+ *
+ */
+struct PackageValue : MessageHeader, PackageFields
+{
+    typedef PackageMessage Object;    ///< class of the message type
+    typedef PackageFields Fields;    ///< fields of the message type
+
+    PackageValue() { this->msgType = PackageMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the ErrorMessage class
+ *
+ */
+struct ErrorValue : MessageHeader, ErrorFields
+{
+    typedef ErrorMessage Object;    ///< class of the message type
+    typedef ErrorFields Fields;    ///< fields of the message type
+
+    ErrorValue() { this->msgType = ErrorMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SBAvailableMessage class
+ *
+ */
+struct SBAvailableValue : MessageHeader, SBAvailableFields
+{
+    typedef SBAvailableMessage Object;    ///< class of the message type
+    typedef SBAvailableFields Fields;    ///< fields of the message type
+
+    SBAvailableValue() { this->msgType = SBAvailableMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SBPositionMessage class
+ *
+ */
+struct SBPositionValue : MessageHeader, SBPositionFields
+{
+    typedef SBPositionMessage Object;    ///< class of the message type
+    typedef SBPositionFields Fields;    ///< fields of the message type
+
+    SBPositionValue() { this->msgType = SBPositionMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SBStateMessage class
+ *
+ */
+struct SBStateValue : MessageHeader, SBStateFields
+{
+    typedef SBStateMessage Object;    ///< class of the message type
+    typedef SBStateFields Fields;    ///< fields of the message type
+
+    SBStateValue() { this->msgType = SBStateMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SBToSVHandshakeMessage class
+ *
+ */
+struct SBToSVHandshakeValue : MessageHeader, SBToSVHandshakeFields
+{
+    typedef SBToSVHandshakeMessage Object;    ///< class of the message type
+    typedef SBToSVHandshakeFields Fields;    ///< fields of the message type
+
+    SBToSVHandshakeValue() { this->msgType = SBToSVHandshakeMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SVAvailableMessage class
+ *
+ */
+struct SVAvailableValue : MessageHeader, SVAvailableFields
+{
+    typedef SVAvailableMessage Object;    ///< class of the message type
+    typedef SVAvailableFields Fields;    ///< fields of the message type
+
+    SVAvailableValue() { this->msgType = SVAvailableMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SVPositionMessage class
+ *
+ */
+struct SVPositionValue : MessageHeader, SVPositionFields
+{
+    typedef SVPositionMessage Object;    ///< class of the message type
+    typedef SVPositionFields Fields;    ///< fields of the message type
+
+    SVPositionValue() { this->msgType = SVPositionMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SVStateMessage class
+ *
+ */
+struct SVStateValue : MessageHeader, SVStateFields
+{
+    typedef SVStateMessage Object;    ///< class of the message type
+    typedef SVStateFields Fields;    ///< fields of the message type
+
+    SVStateValue() { this->msgType = SVStateMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SBToSOHandshakeMessage class
+ *
+ */
+struct SBToSOHandshakeValue : MessageHeader, SBToSOHandshakeFields
+{
+    typedef SBToSOHandshakeMessage Object;    ///< class of the message type
+    typedef SBToSOHandshakeFields Fields;    ///< fields of the message type
+
+    SBToSOHandshakeValue() { this->msgType = SBToSOHandshakeMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SOPositionMessage class
+ *
+ */
+struct SOPositionValue : MessageHeader, SOPositionFields
+{
+    typedef SOPositionMessage Object;    ///< class of the message type
+    typedef SOPositionFields Fields;    ///< fields of the message type
+
+    SOPositionValue() { this->msgType = SOPositionMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SOStateMessage class
+ *
+ */
+struct SOStateValue : MessageHeader, SOStateFields
+{
+    typedef SOStateMessage Object;    ///< class of the message type
+    typedef SOStateFields Fields;    ///< fields of the message type
+
+    SOStateValue() { this->msgType = SOStateMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the SOInitMessage class
+ *
+ */
+struct SOInitValue : MessageHeader, SOInitFields
+{
+    typedef SOInitMessage Object;    ///< class of the message type
+    typedef SOInitFields Fields;    ///< fields of the message type
+
+    SOInitValue() { this->msgType = SOInitMessage::TYPE; }
+};
+
+/**
+ * @brief Value type of the BufferMessage class
+ *
+ */
+struct BufferValue : MessageHeader, BufferFields
+{
+    typedef BufferMessage Object;    ///< class of the message type
+    typedef BufferFields Fields;    ///< fields of the message type
+
+    BufferValue() { this->msgType = BufferMessage::TYPE; }
+};
+
+/**
+ * @brief Any message by value
+ *
+ * The alternatives are ordered like Message::MessageType, so index() is the
+ * message type. std::monostate stands for a failed decode.
+ *
+ */
+typedef std::variant<std::monostate,
+                     PackageValue,
+                     ErrorValue,
+                     SBAvailableValue,
+                     SBPositionValue,
+                     SBStateValue,
+                     SBToSVHandshakeValue,
+                     SVAvailableValue,
+                     SVPositionValue,
+                     SVStateValue,
+                     SBToSOHandshakeValue,
+                     SOPositionValue,
+                     SOStateValue,
+                     SOInitValue,
+                     BufferValue> MessageValue;
+
+static_assert(std::variant_size<MessageValue>::value == Message::MESSAGE_TYPES + 1,
+              "MessageValue needs one alternative per MessageType");
+static_assert(std::is_trivially_copyable<MessageValue>::value,
+              "MessageValue must stay trivially copyable");
+
+/**
+ * @brief Decode a payload in any wire format into a value
+ *
+ * The fields are read straight into the alternative of the payload type.
+ *
+ * @param payload
+ * @param length
+ * @return MessageValue - std::monostate if the payload is malformed, a string
+ *                        exceeds its capacity or the type is unknown
+ */
+MessageValue decodeMessageValue(const char* payload, size_t length);
+
+/**
+ * @brief Serialize a value into a caller-supplied buffer
+ *
+ * @param value
+ * @param buffer
+ * @param size - size of the buffer including the terminating null
+ * @param format
+ * @return size_t - length of the message, zero if the buffer is too small or the value is empty
+ */
+size_t encodeMessageValue(const MessageValue& value, char* buffer, size_t size, WireFormat format = WireFormat::Json);
+
+/**
+ * @brief Serialize a value into a Print
+ *
+ * @param value
+ * @param output
+ * @param format
+ * @return size_t - number of bytes written
+ */
+size_t encodeMessageValue(const MessageValue& value, Print& output, WireFormat format = WireFormat::Json);
+
+/**
+ * @brief Exact number of bytes encodeMessageValue will produce
+ *
+ * @param value
+ * @param format
+ * @return size_t
+ */
+size_t measureMessageValue(const MessageValue& value, WireFormat format = WireFormat::Json);
+
+/**
+ * @brief Set msgLength to the length of the JSON encoding of the value
+ *
+ * @param value
+ */
+void updateMessageLength(MessageValue& value);
+
+/**
+ * @brief Copy a value into a message object
+ *
+ * @param value
+ * @return std::shared_ptr<Message> - nullptr for std::monostate
+ */
+std::shared_ptr<Message> toMessage(const MessageValue& value);
+
+/**
+ * @brief Copy a message object into a value
+ *
+ * @param message
+ * @return MessageValue - std::monostate if the message type is unknown
+ */
+MessageValue toMessageValue(const Message& message);
+
+#endif
+
+#endif
@@ -0,0 +1,484 @@
+/**
+ * @file MessageWriter.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Streaming encoder for the messagetypes
+ * @version 0.1
+ * @date 2020-03-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "MessageWriter.h"
+
+MessageWriter::MessageWriter(WireFormat format) : sink(Sink::Count), format(format)
+{
+}
+
+MessageWriter::MessageWriter(char* buffer, size_t size, WireFormat format) : sink(Sink::Buffer), format(format), buffer(buffer), size(size)
+{
+}
+
+MessageWriter::MessageWriter(Print& output, WireFormat format) : sink(Sink::Output), format(format), output(&output)
+{
+}
+
+MessageWriter::MessageWriter(String& output) : sink(Sink::Text), format(WireFormat::Json), text(&output)
+{
+}
+
+void MessageWriter::write(char c)
+{
+    switch (this->sink)
+    {
+    case Sink::Count:
+        break;
+    case Sink::Buffer:
+        // keep one byte for the terminating null
+        if (this->written + 1 < this->size)
+        {
+            this->buffer[this->written] = c;
+        }
+        else
+        {
+            this->overflow = true;
+        }
+        break;
+    case Sink::Output:
+        this->output->write((uint8_t)c);
+        break;
+    case Sink::Text:
+        this->chunk[this->chunkLength++] = c;
+        if (this->chunkLength == CHUNK_SIZE)
+        {
+            this->flushChunk();
+        }
+        break;
+    }
+    this->written++;
+}
+
+void MessageWriter::write(const char* data, size_t length)
+{
+    switch (this->sink)
+    {
+    case Sink::Count:
+        break;
+    case Sink::Buffer:
+        {
+            // keep one byte for the terminating null
+            size_t available = this->written + 1 < this->size ? this->size - 1 - this->written : 0;
+            if (length > available)
+            {
+                this->overflow = true;
+            }
+            if (available > 0)
+            {
+                memcpy(this->buffer + this->written, data, length < available ? length : available);
+            }
+            break;
+        }
+    case Sink::Output:
+        this->output->write((const uint8_t*)data, length);
+        break;
+    case Sink::Text:
+        for (size_t copied = 0; copied < length;)
+        {
+            size_t part = CHUNK_SIZE - this->chunkLength;
+            if (part > length - copied)
+            {
+                part = length - copied;
+            }
+            memcpy(this->chunk + this->chunkLength, data + copied, part);
+            this->chunkLength += part;
+            copied += part;
+            if (this->chunkLength == CHUNK_SIZE)
+            {
+                this->flushChunk();
+            }
+        }
+        break;
+    }
+    this->written += length;
+}
+
+void MessageWriter::writeKey(const char* key)
+{
+    this->fieldCount++;
+    if (this->format == WireFormat::MsgPack)
+    {
+        this->writeMsgPackString(key, strlen(key));
+        return;
+    }
+    if (!this->firstField)
+    {
+        this->write(',');
+    }
+    this->firstField = false;
+    this->write('"');
+    this->write(key, strlen(key));
+    this->write("\":", 2);
+}
+
+void MessageWriter::writeString(const char* value, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    this->write('"');
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = value[i];
+        if (c != '"' && c != '\\' && (unsigned char)c >= 0x20)
+        {
+            continue;
+        }
+
+        // copy the plain characters in one go, then escape
+        this->write(value + start, i - start);
+        start = i + 1;
+        if (c == '"' || c == '\\')
+        {
+            this->write('\\');
+            this->write(c);
+        }
+        else
+        {
+            this->write("\\u00", 4);
+            this->write(hexDigits[(c >> 4) & 0x0F]);
+            this->write(hexDigits[c & 0x0F]);
+        }
+    }
+    this->write(value + start, length - start);
+    this->write('"');
+}
+
+void MessageWriter::writeNumber(unsigned long value, bool negative)
+{
+    char digits[12];
+    size_t position = sizeof(digits);
+    do
+    {
+        digits[--position] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    if (negative)
+    {
+        digits[--position] = '-';
+    }
+    this->write(digits + position, sizeof(digits) - position);
+}
+
+void MessageWriter::writeVarint(unsigned long value)
+{
+    char bytes[10];
+    size_t length = 0;
+    while (value >= 0x80)
+    {
+        bytes[length++] = (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (char)value;
+    this->write(bytes, length);
+}
+
+void MessageWriter::writeMsgPack(uint8_t type, unsigned long value, size_t bytes)
+{
+    char data[5];
+    data[0] = (char)type;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        data[bytes - i] = (char)(value >> (8 * i));
+    }
+    this->write(data, bytes + 1);
+}
+
+void MessageWriter::writeMsgPackString(const char* value, size_t length)
+{
+    if (length < 32)
+    {
+        this->write((char)(0xA0 | length));
+    }
+    else if (length <= 0xFF)
+    {
+        this->writeMsgPack(0xD9, length, 1);
+    }
+    else
+    {
+        this->writeMsgPack(0xDA, length, 2);
+    }
+    this->write(value, length);
+}
+
+void MessageWriter::flushChunk()
+{
+    if (this->chunkLength > 0)
+    {
+        this->chunk[this->chunkLength] = '\0';
+        this->text->concat(this->chunk);
+        this->chunkLength = 0;
+    }
+}
+
+void MessageWriter::beginObject(size_t fields)
+{
+    this->firstField = true;
+    this->fieldCount = 0;
+    switch (this->format)
+    {
+    case WireFormat::Json:
+        this->write('{');
+        break;
+    case WireFormat::Binary:
+        this->write((char)MESSAGE_BINARY_MAGIC);
+        break;
+    case WireFormat::MsgPack:
+        if (fields < 16)
+        {
+            this->write((char)(0x80 | fields));
+        }
+        else
+        {
+            this->writeMsgPack(0xDE, fields, 2);
+        }
+        break;
+    }
+}
+
+void MessageWriter::endObject()
+{
+    if (this->format == WireFormat::Json)
+    {
+        this->write('}');
+    }
+    if (this->sink == Sink::Buffer && this->size > 0)
+    {
+        this->buffer[this->written < this->size ? this->written : this->size - 1] = '\0';
+    }
+    else if (this->sink == Sink::Text)
+    {
+        this->flushChunk();
+    }
+}
+
+void MessageWriter::beginBatch(size_t count)
+{
+    this->firstItem = true;
+    if (this->format == WireFormat::Json)
+    {
+        this->write('[');
+    }
+    else
+    {
+        this->write((char)MESSAGE_BATCH_MAGIC);
+        this->writeVarint(count);
+    }
+}
+
+void MessageWriter::batchItem(size_t length)
+{
+    if (this->format == WireFormat::Json)
+    {
+        if (!this->firstItem)
+        {
+            this->write(',');
+        }
+    }
+    else
+    {
+        this->writeVarint(length);
+    }
+    this->firstItem = false;
+}
+
+void MessageWriter::endBatch()
+{
+    if (this->format == WireFormat::Json)
+    {
+        this->write(']');
+    }
+    if (this->sink == Sink::Buffer && this->size > 0)
+    {
+        this->buffer[this->written < this->size ? this->written : this->size - 1] = '\0';
+    }
+    else if (this->sink == Sink::Text)
+    {
+        this->flushChunk();
+    }
+}
+
+void MessageWriter::field(const char* key, unsigned int value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        this->writeVarint(value);
+        return;
+    }
+    this->writeKey(key);
+    if (this->format == WireFormat::MsgPack)
+    {
+        if (value < 0x80)
+        {
+            this->write((char)value);
+        }
+        else if (value <= 0xFF)
+        {
+            this->writeMsgPack(0xCC, value, 1);
+        }
+        else if (value <= 0xFFFF)
+        {
+            this->writeMsgPack(0xCD, value, 2);
+        }
+        else
+        {
+            this->writeMsgPack(0xCE, value, 4);
+        }
+        return;
+    }
+    this->writeNumber(value, false);
+}
+
+void MessageWriter::field(const char* key, int value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        // zigzag encoding keeps small negative numbers short
+        this->writeVarint(value < 0 ? ((unsigned long)(-(value + 1)) << 1) | 1 : (unsigned long)value << 1);
+        return;
+    }
+    if (this->format == WireFormat::MsgPack && value >= 0)
+    {
+        this->field(key, (unsigned int)value);
+        return;
+    }
+    this->writeKey(key);
+    if (this->format == WireFormat::MsgPack)
+    {
+        if (value >= -32)
+        {
+            this->write((char)(int8_t)value);
+        }
+        else if (value >= -128)
+        {
+            this->writeMsgPack(0xD0, (unsigned long)(uint8_t)(int8_t)value, 1);
+        }
+        else if (value >= -32768)
+        {
+            this->writeMsgPack(0xD1, (unsigned long)(uint16_t)(int16_t)value, 2);
+        }
+        else
+        {
+            this->writeMsgPack(0xD2, (unsigned long)(uint32_t)(int32_t)value, 4);
+        }
+        return;
+    }
+    // negate in unsigned arithmetic so INT_MIN does not overflow
+    this->writeNumber(value < 0 ? 0UL - (unsigned long)value : (unsigned long)value, value < 0);
+}
+
+void MessageWriter::field(const char* key, bool value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        this->write((char)(value ? 1 : 0));
+        return;
+    }
+    this->writeKey(key);
+    if (this->format == WireFormat::MsgPack)
+    {
+        this->write((char)(value ? 0xC3 : 0xC2));
+        return;
+    }
+    if (value)
+    {
+        this->write("true", 4);
+    }
+    else
+    {
+        this->write("false", 5);
+    }
+}
+
+void MessageWriter::writeStringField(const char* key, const char* value, size_t length)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        this->writeVarint(length);
+        this->write(value, length);
+        return;
+    }
+    this->writeKey(key);
+    if (this->format == WireFormat::MsgPack)
+    {
+        this->writeMsgPackString(value, length);
+        return;
+    }
+    this->writeString(value, length);
+}
+
+void MessageWriter::field(const char* key, const String& value)
+{
+    this->writeStringField(key, value.c_str(), value.length());
+}
+
+void MessageWriter::field(const char* key, const MessageSymbol& value)
+{
+    if (this->format == WireFormat::Binary)
+    {
+        // seeded symbols have the same code on every device
+        if (value.seeded())
+        {
+            this->writeVarint(value.id() + 1UL);
+            return;
+        }
+        this->writeVarint(0);
+    }
+    this->writeStringField(key, value.c_str(), value.length());
+}
+
+void MessageWriter::fields(const MessageFieldTable& table, const void* data)
+{
+    const char* base = static_cast<const char*>(data);
+    for (size_t i = 0; i < table.count; i++)
+    {
+        const MessageField& descriptor = table.fields[i];
+        const void* member = base + descriptor.offset;
+        switch (descriptor.type)
+        {
+        case FieldType::Unsigned:
+            this->field(descriptor.key, *static_cast<const unsigned int*>(member));
+            break;
+        case FieldType::Signed:
+            this->field(descriptor.key, *static_cast<const int*>(member));
+            break;
+        case FieldType::Boolean:
+            this->field(descriptor.key, *static_cast<const bool*>(member));
+            break;
+        case FieldType::Text:
+            this->writeStringField(descriptor.key, FixedStringAccess::characters(member, descriptor.capacity), FixedStringAccess::length(member, descriptor.capacity));
+            break;
+        case FieldType::Symbol:
+            this->field(descriptor.key, *static_cast<const MessageSymbol*>(member));
+            break;
+        }
+    }
+}
+
+size_t MessageWriter::length() const
+{
+    return this->written;
+}
+
+WireFormat MessageWriter::wireFormat() const
+{
+    return this->format;
+}
+
+size_t MessageWriter::fields() const
+{
+    return this->fieldCount;
+}
+
+bool MessageWriter::overflowed() const
+{
+    return this->overflow;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file MessageWriter.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Streaming encoder for the messagetypes
+ * @version 0.1
+ * @date 2020-03-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGEWRITER_H__
+#define MESSAGEWRITER_H__
+
+#include <Arduino.h>
+
+#include "FixedString.h"
+#include "MessageField.h"
+#include "MessageFormat.h"
+#include "MessageSymbol.h"
+
+/**
+ * @brief Writes the fields of a message directly into a buffer, a Print or a String
+ *
+ * The writer never allocates. Numbers are formatted into a small stack
+ * buffer and strings are escaped while they are copied. Binary and MsgPack
+ * output may contain null bytes and must not be written into a String.
+ *
+ */
+class MessageWriter
+{
+private:
+
+    /**
+     * @brief Destination of the written bytes
+     *
+     */
+    enum class Sink
+    {
+        Count,
+        Buffer,
+        Output,
+        Text
+    };
+
+    static const size_t CHUNK_SIZE = 32;        ///< size of the chunk used to append to a String
+
+    Sink sink;                                  ///< destination of the written bytes
+    WireFormat format;                          ///< format of the output
+    char* buffer = nullptr;                     ///< destination buffer
+    size_t size = 0;                            ///< size of the destination buffer
+    Print* output = nullptr;                    ///< destination print
+    String* text = nullptr;                     ///< destination string
+    char chunk[CHUNK_SIZE + 1];                 ///< pending bytes for the destination string
+    size_t chunkLength = 0;                     ///< number of pending bytes
+    size_t written = 0;                         ///< number of bytes written
+    bool overflow = false;                      ///< destination buffer was too small
+    bool firstField = true;                     ///< no separator before the next field
+    size_t fieldCount = 0;                      ///< number of fields written
+    bool firstItem = true;                      ///< no separator before the next message of a batch
+
+    /**
+     * @brief Write a single character to the sink
+     *
+     * @param c
+     */
+    void write(char c);
+
+    /**
+     * @brief Write raw characters to the sink
+     *
+     * @param data
+     * @param length
+     */
+    void write(const char* data, size_t length);
+
+    /**
+     * @brief Write the separator and the quoted key of a field
+     *
+     * @param key
+     */
+    void writeKey(const char* key);
+
+    /**
+     * @brief Write a quoted and escaped string
+     *
+     * @param value
+     * @param length
+     */
+    void writeString(const char* value, size_t length);
+
+    /**
+     * @brief Write the decimal digits of a number
+     *
+     * @param value
+     * @param negative
+     */
+    void writeNumber(unsigned long value, bool negative);
+
+    /**
+     * @brief Write an unsigned number as binary varint
+     *
+     * @param value
+     */
+    void writeVarint(unsigned long value);
+
+    /**
+     * @brief Write a MessagePack type byte followed by a big-endian value
+     *
+     * @param type
+     * @param value
+     * @param bytes - number of value bytes
+     */
+    void writeMsgPack(uint8_t type, unsigned long value, size_t bytes);
+
+    /**
+     * @brief Write a MessagePack string
+     *
+     * @param value
+     * @param length
+     */
+    void writeMsgPackString(const char* value, size_t length);
+
+    /**
+     * @brief Write a string field
+     *
+     * @param key
+     * @param value
+     * @param length
+     */
+    void writeStringField(const char* key, const char* value, size_t length);
+
+    /**
+     * @brief Append the pending chunk to the destination string
+     *
+     */
+    void flushChunk();
+
+public:
+
+    /**
+     * @brief Construct a writer that only counts the bytes
+     *
+     * @param format
+     */
+    explicit MessageWriter(WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Construct a writer into a caller-supplied buffer
+     *
+     * The output is null-terminated if it fits.
+     *
+     * @param buffer
+     * @param size - size of the buffer including the terminating null
+     * @param format
+     */
+    MessageWriter(char* buffer, size_t size, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Construct a writer into a Print (Serial, WiFiClient, ...)
+     *
+     * @param output
+     * @param format
+     */
+    explicit MessageWriter(Print& output, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Construct a writer appending to a String
+     *
+     * @param output
+     */
+    explicit MessageWriter(String& output);
+
+    /**
+     * @brief Begin the message object
+     *
+     * @param fields - number of fields, only needed for MsgPack
+     */
+    void beginObject(size_t fields = 0);
+
+    /**
+     * @brief End the message object and flush pending output
+     *
+     */
+    void endObject();
+
+    /**
+     * @brief Begin a frame of several messages
+     *
+     * JSON frames are an array, binary and MsgPack frames start with
+     * MESSAGE_BATCH_MAGIC and the number of messages.
+     *
+     * @param count - number of messages, not needed for JSON
+     */
+    void beginBatch(size_t count = 0);
+
+    /**
+     * @brief Begin the next message of a batch, write it with beginObject and endObject
+     *
+     * @param length - number of bytes of the message, not needed for JSON
+     */
+    void batchItem(size_t length = 0);
+
+    /**
+     * @brief End a frame of several messages and flush pending output
+     *
+     */
+    void endBatch();
+
+    /**
+     * @brief Write an unsigned number field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, unsigned int value);
+
+    /**
+     * @brief Write a signed number field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, int value);
+
+    /**
+     * @brief Write a boolean field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, bool value);
+
+    /**
+     * @brief Write a string field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, const String& value);
+
+    /**
+     * @brief Write a symbol field
+     *
+     * @param key
+     * @param value
+     */
+    void field(const char* key, const MessageSymbol& value);
+
+    /**
+     * @brief Write a fixed-capacity string field
+     *
+     * @tparam N
+     * @param key
+     * @param value
+     */
+    template <size_t N>
+    void field(const char* key, const FixedString<N>& value)
+    {
+        this->writeStringField(key, value.c_str(), value.length());
+    }
+
+    /**
+     * @brief Write all fields described by a field table
+     *
+     * @param table
+     * @param data - fields struct the table describes
+     */
+    void fields(const MessageFieldTable& table, const void* data);
+
+    /**
+     * @brief Number of bytes written so far (or needed, if the buffer overflowed)
+     *
+     * @return size_t
+     */
+    size_t length() const;
+
+    /**
+     * @brief Format of the output
+     *
+     * @return WireFormat
+     */
+    WireFormat wireFormat() const;
+
+    /**
+     * @brief Number of fields written so far
+     *
+     * @return size_t
+     */
+    size_t fields() const;
+
+    /**
+     * @brief Check if the destination buffer was too small
+     *
+     * @return true
+     * @return false
+     */
+    bool overflowed() const;
+};
+
+#endif
@@ -10,6 +10,13 @@
  */
 #include "Messages.h"
 
+#include <cstddef>
+
+#include "MessageRegistry.h"
+#include "MessageFlatJson.h"
+#include "MessageStructural.h"
+#include "MessageMetrics.h"
+
 //======================BASECLASS=======================================================
 //=======================================================================================
 Message::Message()
@@ -17,192 +24,1244 @@ Message::Message()
 }
 
 
-Message::~Message()
+Message::~Message()
+{
+}
+
+
+std::shared_ptr<Message> Message::createMessage(MessageType type)
+{
+    MESSAGE_FUNCCALLln("Message::createMessage(MessageType)");
+    // Look up the pooled message class of the type in the registry
+    std::shared_ptr<Message> retVal = RegisteredMessages::create(type);
+    if (!retVal)
+    {
+        MESSAGE_WARNING("Translation failed");
+    }
+    return retVal;
+}
+
+std::shared_ptr<Message> Message::obtainMessage(MessageType type, const std::shared_ptr<Message>& into)
+{
+    if (!into)
+    {
+        return createMessage(type);
+    }
+    return into->msgType == type ? into : nullptr;
+}
+
+std::shared_ptr<Message> Message::translateJsonToStruct(const char* payload, unsigned int length, MessageFieldMask projection)
+{
+    MESSAGE_FUNCCALLln("Message::translateJsonToStruct(const char*, unsigned int, MessageFieldMask)");
+    // Deserialize the object to a stack document sized for the largest message,
+    // a MessagePack map has the same keys and fits into the same document
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+    DecodeStatus status;
+    return decode(payload, length, tempJson, status, projection);
+}
+
+Message::BatchResult Message::translateBatch(const MessagePayload* payloads, size_t count, std::shared_ptr<Message>* messages, DecodeStatus* status)
+{
+    MESSAGE_FUNCCALLln("Message::translateBatch(const MessagePayload*, size_t, std::shared_ptr<Message>*, DecodeStatus*)");
+    // One document for the whole burst, every deserialization clears it
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+    BatchResult retVal = {0, 0, true};
+    for (size_t i = 0; i < count; i++)
+    {
+        decodeItem(payloads[i], tempJson, messages, status, retVal);
+    }
+    return retVal;
+}
+
+void Message::decodeItem(const MessagePayload& item, JsonDocument& document, std::shared_ptr<Message>* messages, DecodeStatus* status, BatchResult& result)
+{
+    DecodeStatus itemStatus;
+    messages[result.items] = decode(item.data, item.length, document, itemStatus);
+    if (status)
+    {
+        status[result.items] = itemStatus;
+    }
+    if (itemStatus != DecodeStatus::Ok)
+    {
+        result.failed++;
+    }
+    result.items++;
+}
+
+/**
+ * @brief Skip JSON whitespace
+ * 
+ * @param frame 
+ * @param length 
+ * @param position - first byte to check, set to the first other byte
+ */
+static void skipWhitespace(const char* frame, size_t length, size_t& position)
+{
+    while (position < length && (frame[position] == ' ' || frame[position] == '\t' ||
+                                 frame[position] == '\n' || frame[position] == '\r'))
+    {
+        position++;
+    }
+}
+
+/**
+ * @brief Length of the JSON object starting at the frame, without parsing it
+ * 
+ * Only structural bytes are visited if an index is given.
+ * 
+ * @param frame
+ * @param start - first byte is the opening brace
+ * @param length - bytes of the frame
+ * @param structurals - index over the frame or nullptr
+ * @return size_t - number of bytes up to and including the closing brace, zero if unterminated
+ */
+static size_t jsonObjectLength(const char* frame, size_t start, size_t length, MessageStructuralIndex* structurals)
+{
+    size_t depth = 0;
+    bool inString = false;
+    for (size_t i = start; i < length; i++)
+    {
+        if (structurals)
+        {
+            i = structurals->nextFrom(i);
+            if (i >= length)
+            {
+                break;
+            }
+        }
+        char c = frame[i];
+        if (inString)
+        {
+            if (c == '\\')
+            {
+                i++;
+            }
+            else if (c == '"')
+            {
+                inString = false;
+            }
+        }
+        else if (c == '"')
+        {
+            inString = true;
+        }
+        else if (c == '{' || c == '[')
+        {
+            depth++;
+        }
+        else if ((c == '}' || c == ']') && --depth == 0)
+        {
+            return i + 1 - start;
+        }
+    }
+    return 0;
+}
+
+Message::BatchResult Message::translateJsonArray(const char* frame, size_t length, std::shared_ptr<Message>* messages, size_t capacity, DecodeStatus* status)
+{
+    MESSAGE_FUNCCALLln("Message::translateJsonArray(const char*, size_t, std::shared_ptr<Message>*, size_t, DecodeStatus*)");
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+#if MESSAGE_STRUCTURAL_INDEX
+    MessageStructuralIndex index(frame, length);
+    MessageStructuralIndex* structurals = &index;
+#else
+    MessageStructuralIndex* structurals = nullptr;
+#endif
+    BatchResult retVal = {0, 0, false};
+    size_t position = 0;
+    skipWhitespace(frame, length, position);
+    if (position == length || frame[position] != '[')
+    {
+        MESSAGE_WARNINGln("Batch frame is not a JSON array");
+        return retVal;
+    }
+    position++;
+    skipWhitespace(frame, length, position);
+    if (position < length && frame[position] == ']')
+    {
+        retVal.complete = true;
+        return retVal;
+    }
+
+    while (position < length)
+    {
+        size_t objectLength = frame[position] == '{' ? jsonObjectLength(frame, position, length, structurals) : 0;
+        if (objectLength == 0)
+        {
+            MESSAGE_WARNINGln("Batch frame element is not a JSON object");
+            return retVal;
+        }
+        if (retVal.items == capacity)
+        {
+            MESSAGE_WARNINGln("Batch frame has more messages than capacity");
+            return retVal;
+        }
+
+        decodeItem({frame + position, objectLength}, tempJson, messages, status, retVal);
+
+        // Continue after the separator or stop at the end of the array
+        position += objectLength;
+        skipWhitespace(frame, length, position);
+        if (position < length && frame[position] == ']')
+        {
+            retVal.complete = true;
+            return retVal;
+        }
+        if (position == length || frame[position] != ',')
+        {
+            break;
+        }
+        position++;
+        skipWhitespace(frame, length, position);
+    }
+    MESSAGE_WARNINGln("Batch frame is not terminated");
+    return retVal;
+}
+
+Message::BatchResult Message::translateFrame(const char* frame, size_t length, std::shared_ptr<Message>* messages, size_t capacity, DecodeStatus* status)
+{
+    MESSAGE_FUNCCALLln("Message::translateFrame(const char*, size_t, std::shared_ptr<Message>*, size_t, DecodeStatus*)");
+    BatchResult retVal = {0, 0, false};
+    if (length == 0 || capacity == 0)
+    {
+        return retVal;
+    }
+    if ((uint8_t)frame[0] != MESSAGE_BATCH_MAGIC)
+    {
+        size_t position = 0;
+        skipWhitespace(frame, length, position);
+        if (position < length && frame[position] == '[')
+        {
+            return translateJsonArray(frame, length, messages, capacity, status);
+        }
+        MessagePayload payload = {frame, length};
+        return translateBatch(&payload, 1, messages, status);
+    }
+
+    // Slice the messages out of the frame, they are decoded in place
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+    MessageReader reader((const uint8_t*)frame, length);
+    size_t count = reader.beginBatch();
+    MessagePayload item;
+    while (retVal.items < count && retVal.items < capacity && reader.batchItem(item))
+    {
+        decodeItem(item, tempJson, messages, status, retVal);
+    }
+    if (reader.failed())
+    {
+        MESSAGE_WARNINGln("Batch frame truncated");
+    }
+    else if (retVal.items < count)
+    {
+        MESSAGE_WARNINGln("Batch frame has more messages than capacity");
+    }
+    else
+    {
+        retVal.complete = true;
+    }
+    return retVal;
+}
+
+void Message::writeBatch(MessageWriter& writer, const std::shared_ptr<Message>* messages, size_t count, bool record)
+{
+    // Binary and MsgPack messages are prefixed with their length, measured in a dry run
+    writer.beginBatch(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        writer.batchItem(writer.wireFormat() == WireFormat::Json ? 0 : messages[i]->measure(writer.wireFormat()));
+        uint32_t started = MessageMetrics::start();
+        size_t offset = writer.length();
+        messages[i]->writeMessage(writer);
+        if (record)
+        {
+            MessageMetrics::recordEncode(messages[i]->msgType, writer.length() - offset, !writer.overflowed(), started);
+        }
+    }
+    writer.endBatch();
+}
+
+size_t Message::serializeBatch(const std::shared_ptr<Message>* messages, size_t count, char* buffer, size_t size, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::serializeBatch(const std::shared_ptr<Message>*, size_t, char*, size_t, WireFormat)");
+    MessageWriter writer(buffer, size, format);
+    writeBatch(writer, messages, count, true);
+    return writer.overflowed() ? 0 : writer.length();
+}
+
+size_t Message::serializeBatch(const std::shared_ptr<Message>* messages, size_t count, Print& output, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::serializeBatch(const std::shared_ptr<Message>*, size_t, Print&, WireFormat)");
+    MessageWriter writer(output, format);
+    writeBatch(writer, messages, count, true);
+    return writer.length();
+}
+
+size_t Message::measureBatch(const std::shared_ptr<Message>* messages, size_t count, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::measureBatch(const std::shared_ptr<Message>*, size_t, WireFormat)");
+    MessageWriter counter(format);
+    writeBatch(counter, messages, count, false);
+    return counter.length();
+}
+
+std::shared_ptr<Message> Message::decode(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection)
+{
+    MESSAGE_FUNCCALLln("Message::decode(const char*, size_t, JsonDocument&, DecodeStatus&, MessageFieldMask)");
+    uint32_t started = MessageMetrics::start();
+    std::shared_ptr<Message> retVal = parsePayload(payload, length, document, status, projection, MESSAGE_FLAT_JSON, nullptr);
+    MessageMetrics::recordDecode(retVal ? retVal->msgType : MessageType::DEFAULTMESSAGETYPE, length, status == DecodeStatus::Ok, started);
+    return retVal;
+}
+
+std::shared_ptr<Message> Message::decodeDocument(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection)
+{
+    MESSAGE_FUNCCALLln("Message::decodeDocument(const char*, size_t, JsonDocument&, DecodeStatus&, MessageFieldMask)");
+    uint32_t started = MessageMetrics::start();
+    std::shared_ptr<Message> retVal = parsePayload(payload, length, document, status, projection, false, nullptr);
+    MessageMetrics::recordDecode(retVal ? retVal->msgType : MessageType::DEFAULTMESSAGETYPE, length, status == DecodeStatus::Ok, started);
+    return retVal;
+}
+
+DecodeStatus Message::decodeInto(Message& message, const char* payload, size_t length, MessageFieldMask projection)
+{
+    MESSAGE_FUNCCALLln("Message::decodeInto(Message&, const char*, size_t, MessageFieldMask)");
+    uint32_t started = MessageMetrics::start();
+    // Aliases the message without owning it, no control block is allocated
+    std::shared_ptr<Message> into(std::shared_ptr<Message>(), &message);
+    DecodeStatus status = DecodeStatus::Ok;
+    WireFormat format = detectWireFormat(payload, length);
+    if (format == WireFormat::Binary)
+    {
+        translateBinaryToStruct((const uint8_t*)payload, length, status, projection, into);
+    }
+    else if (!MESSAGE_FLAT_JSON || format != WireFormat::Json || !translateFlatJson(payload, length, projection, into))
+    {
+        status = decodeIntoDocument(payload, length, projection, into);
+    }
+    MessageMetrics::recordDecode(message.msgType, length, status == DecodeStatus::Ok, started);
+    return status;
+}
+
+__attribute__((noinline))
+DecodeStatus Message::decodeIntoDocument(const char* payload, size_t length, MessageFieldMask projection, const std::shared_ptr<Message>& into)
+{
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+    DecodeStatus status;
+    parsePayload(payload, length, tempJson, status, projection, false, into);
+    return status;
+}
+
+DeserializationError Message::deserializePayload(const char* payload, size_t length, WireFormat format, JsonDocument& document, MessageFieldMask projection)
+{
+    // The type is peeked first, unknown types and oversized tables are parsed without filter
+    MessageHeader header;
+    MessageFieldTable table = peekHeader(payload, length, header) ? RegisteredMessages::fields(header.msgType) : MessageFieldTable();
+    if (!table.fields || table.count > MESSAGE_FILTER_FIELDS)
+    {
+        return format == WireFormat::MsgPack
+            ? deserializeMsgPack(document, payload, length)
+            : deserializeJson(document, payload, length);
+    }
+
+    // Keys are string literals, the filter stores only pointers to them
+    StaticJsonDocument<JSON_OBJECT_SIZE(4 + MESSAGE_FILTER_FIELDS)> filter;
+    filter["msgId"] = true;
+    filter["msgType"] = true;
+    filter["msgLength"] = true;
+    filter["msgConsignor"] = true;
+    for (size_t i = 0; i < table.count; i++)
+    {
+        if (projection & ((MessageFieldMask)1 << i))
+        {
+            filter[table.fields[i].key] = true;
+        }
+    }
+    return format == WireFormat::MsgPack
+        ? deserializeMsgPack(document, payload, length, DeserializationOption::Filter(filter))
+        : deserializeJson(document, payload, length, DeserializationOption::Filter(filter));
+}
+
+std::shared_ptr<Message> Message::parsePayload(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection, bool flat, const std::shared_ptr<Message>& into)
+{
+    WireFormat format = detectWireFormat(payload, length);
+    if (format == WireFormat::Binary)
+    {
+        return translateBinaryToStruct((const uint8_t*)payload, length, status, projection, into);
+    }
+    if (flat && format == WireFormat::Json)
+    {
+        std::shared_ptr<Message> retVal = translateFlatJson(payload, length, projection, into);
+        if (retVal)
+        {
+            status = DecodeStatus::Ok;
+            return retVal;
+        }
+    }
+
+    DeserializationError error = deserializePayload(payload, length, format, document, projection);
+    if (error == DeserializationError::NoMemory)
+    {
+        MESSAGE_WARNINGln("Payload exceeds MESSAGE_JSON_CAPACITY");
+    }
+    JsonObjectConst root = document.as<JsonObjectConst>();
+    
+    std::shared_ptr<Message> retVal = obtainMessage((MessageType)(root["msgType"].as<unsigned int>()), into);
+    if (error)
+    {
+        status = error == DeserializationError::NoMemory ? DecodeStatus::NoMemory : DecodeStatus::Malformed;
+        // The type of a malformed payload may be unreadable, the target of decodeInto is marked anyway
+        std::shared_ptr<Message> failed = retVal ? retVal : into;
+        if (failed)
+        {
+            failed->parseJSONToStruct(root, error);
+        }
+    }
+    else if (!retVal)
+    {
+        status = into ? DecodeStatus::WrongType : DecodeStatus::UnknownType;
+    }
+    else
+    {
+        status = retVal->readJson(root, projection) ? DecodeStatus::Ok : DecodeStatus::Invalid;
+    }
+    return retVal;
+}
+
+//======================PEEK=============================================================
+//=======================================================================================
+
+/**
+ * @brief Number of frame fields, in the order of the binary layout
+ * 
+ */
+static const size_t HEADER_FIELDS = 4;
+static const unsigned int HEADER_COMPLETE = (1u << HEADER_FIELDS) - 1;
+static const unsigned int HEADER_TYPE = 1u << 1;
+
+/**
+ * @brief Index of a frame field from its key
+ * 
+ * @param key - not null-terminated
+ * @param length 
+ * @return size_t - HEADER_FIELDS for any other key
+ */
+static size_t headerField(const char* key, size_t length)
+{
+    static const char* const names[HEADER_FIELDS] = {"msgId", "msgType", "msgLength", "msgConsignor"};
+    for (size_t i = 0; i < HEADER_FIELDS; i++)
+    {
+        if (strlen(names[i]) == length && memcmp(names[i], key, length) == 0)
+        {
+            return i;
+        }
+    }
+    return HEADER_FIELDS;
+}
+
+static void setHeaderField(MessageHeader& header, size_t field, uint32_t value)
+{
+    switch (field)
+    {
+    case 0:
+        header.msgId = value;
+        break;
+    case 1:
+        header.msgType = (Message::MessageType)value;
+        break;
+    case 2:
+        header.msgLength = value;
+        break;
+    default:
+        header.msgConsignor = (Consignor)value;
+        break;
+    }
+}
+
+/**
+ * @brief Read the frame, the first fields of every message
+ * 
+ * @param reader 
+ * @param header 
+ */
+static void readFrame(MessageReader& reader, MessageHeader& header)
+{
+    unsigned int type = 0;
+    unsigned int consignor = 0;
+    reader.beginObject();
+    reader.field("msgId", header.msgId);
+    reader.field("msgType", type);
+    reader.field("msgLength", header.msgLength);
+    reader.field("msgConsignor", consignor);
+    header.msgType = (Message::MessageType)type;
+    header.msgConsignor = (Consignor)consignor;
+}
+
+/**
+ * @brief Length of the JSON value starting at the input, without parsing it
+ * 
+ * @param value - first byte of the value
+ * @param length - bytes available
+ * @return size_t - zero if the value is unterminated
+ */
+static size_t jsonValueLength(const char* value, size_t length)
+{
+    if (value[0] == '{' || value[0] == '[')
+    {
+        return jsonObjectLength(value, 0, length, nullptr);
+    }
+    if (value[0] == '"')
+    {
+        for (size_t i = 1; i < length; i++)
+        {
+            if (value[i] == '\\')
+            {
+                i++;
+            }
+            else if (value[i] == '"')
+            {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+    // number, true, false or null
+    size_t i = 0;
+    while (i < length && value[i] != ',' && value[i] != '}' && value[i] != ']' &&
+           value[i] != ' ' && value[i] != '\t' && value[i] != '\n' && value[i] != '\r')
+    {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief Read the frame fields from the members of a JSON object
+ * 
+ * Stops behind the last frame field, the specific fields are not scanned.
+ * 
+ * @param payload 
+ * @param length 
+ * @param header 
+ * @param found - bit per frame field that was read
+ * @return true 
+ * @return false - the object is malformed before the end of the frame
+ */
+static bool peekJsonHeader(const char* payload, size_t length, MessageHeader& header, unsigned int& found)
+{
+    size_t position = 0;
+    skipWhitespace(payload, length, position);
+    if (position >= length || payload[position] != '{')
+    {
+        return false;
+    }
+    position++;
+    while (found != HEADER_COMPLETE)
+    {
+        skipWhitespace(payload, length, position);
+        if (position < length && payload[position] == '}')
+        {
+            return true;
+        }
+        if (position >= length || payload[position] != '"')
+        {
+            return false;
+        }
+        size_t key = ++position;
+        while (position < length && payload[position] != '"')
+        {
+            position += payload[position] == '\\' ? 2 : 1;
+        }
+        if (position >= length)
+        {
+            return false;
+        }
+        size_t field = headerField(payload + key, position - key);
+        position++;
+        skipWhitespace(payload, length, position);
+        if (position >= length || payload[position] != ':')
+        {
+            return false;
+        }
+        position++;
+        skipWhitespace(payload, length, position);
+        if (position >= length)
+        {
+            return false;
+        }
+
+        if (field < HEADER_FIELDS)
+        {
+            // Legacy writers quote the numbers
+            bool quoted = payload[position] == '"';
+            position += quoted ? 1 : 0;
+            uint32_t value = 0;
+            size_t digits = 0;
+            while (position < length && payload[position] >= '0' && payload[position] <= '9' && digits < MESSAGE_NUMBER_LENGTH)
+            {
+                value = value * 10 + (uint32_t)(payload[position] - '0');
+                position++;
+                digits++;
+            }
+            if (digits == 0 || (quoted && (position >= length || payload[position++] != '"')))
+            {
+                return false;
+            }
+            setHeaderField(header, field, value);
+            found |= 1u << field;
+        }
+        else
+        {
+            size_t value = jsonValueLength(payload + position, length - position);
+            if (value == 0)
+            {
+                return false;
+            }
+            position += value;
+        }
+
+        skipWhitespace(payload, length, position);
+        if (position < length && payload[position] == ',')
+        {
+            position++;
+        }
+        else if (position < length && payload[position] == '}')
+        {
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Read the frame fields from the entries of a MessagePack map
+ * 
+ * @param payload 
+ * @param length 
+ * @param header 
+ * @param found - bit per frame field that was read
+ * @return true 
+ * @return false - the map is malformed before the end of the frame
+ */
+static bool peekMsgPackHeader(const uint8_t* payload, size_t length, MessageHeader& header, unsigned int& found)
+{
+    size_t entries = 0;
+    size_t position = 0;
+    if ((payload[0] & 0xF0) == 0x80)
+    {
+        entries = payload[0] & 0x0F;
+        position = 1;
+    }
+    else
+    {
+        size_t bytes = payload[0] == 0xDE ? 2 : 4;
+        if (length < 1 + bytes)
+        {
+            return false;
+        }
+        entries = msgPackReadBigEndian(payload + 1, bytes);
+        position = 1 + bytes;
+    }
+
+    for (size_t i = 0; i < entries && found != HEADER_COMPLETE; i++)
+    {
+        bool valid = true;
+        size_t key = position < length ? msgPackScalarLength(payload + position, length - position, valid) : 0;
+        if (!valid || key == 0 || key > length - position)
+        {
+            return false;
+        }
+        // Keys are fixstr or str 8
+        size_t field = HEADER_FIELDS;
+        if ((payload[position] & 0xE0) == 0xA0)
+        {
+            field = headerField((const char*)payload + position + 1, key - 1);
+        }
+        else if (payload[position] == 0xD9)
+        {
+            field = headerField((const char*)payload + position + 2, key - 2);
+        }
+        position += key;
+
+        size_t value = position < length ? msgPackScalarLength(payload + position, length - position, valid) : 0;
+        if (!valid || value == 0 || value > length - position)
+        {
+            return false;
+        }
+        if (field < HEADER_FIELDS)
+        {
+            uint8_t type = payload[position];
+            if (type <= 0x7F)
+            {
+                setHeaderField(header, field, type);
+            }
+            else if (type == 0xCC || type == 0xCD || type == 0xCE)
+            {
+                setHeaderField(header, field, msgPackReadBigEndian(payload + position + 1, value - 1));
+            }
+            else
+            {
+                return false;
+            }
+            found |= 1u << field;
+        }
+        position += value;
+    }
+    return true;
+}
+
+bool Message::peekHeader(const char* payload, size_t length, MessageHeader& header)
+{
+    MESSAGE_FUNCCALLln("Message::peekHeader(const char*, size_t, MessageHeader&)");
+    header = MessageHeader();
+    unsigned int found = 0;
+    switch (detectWireFormat(payload, length))
+    {
+    case WireFormat::Binary:
+        {
+            // The binary frame is always written first and in order
+            MessageReader reader((const uint8_t*)payload, length);
+            readFrame(reader, header);
+            return !reader.failed();
+        }
+    case WireFormat::MsgPack:
+        return peekMsgPackHeader((const uint8_t*)payload, length, header, found) && (found & HEADER_TYPE);
+    case WireFormat::Json:
+        break;
+    }
+    return peekJsonHeader(payload, length, header, found) && (found & HEADER_TYPE);
+}
+
+//======================FLAT=============================================================
+//=======================================================================================
+
+/**
+ * @brief Read a flat JSON object into a frame and the fields struct chosen by a record target
+ * 
+ * The frame comes first. target is called once the type is known, at the
+ * first specific field or at the end for a type without specific fields.
+ * 
+ * @param payload 
+ * @param length 
+ * @param header - set to the frame
+ * @param target 
+ * @param context 
+ * @param projection 
+ * @return true - the object was read completely, with every projected field
+ * @return false - to fall back to ArduinoJson, the fields may be partly written
+ */
+static bool readFlatJson(const char* payload, size_t length, MessageHeader& header, Message::RecordTarget target, void* context, MessageFieldMask projection)
+{
+#if MESSAGE_STRUCTURAL_INDEX
+    MessageStructuralIndex structurals(payload, length);
+    MessageFlatJson parser(payload, length, &structurals);
+#else
+    MessageFlatJson parser(payload, length);
+#endif
+    unsigned int found = 0;
+    MessageFieldTable table;
+    void* fields = nullptr;
+    MessageFieldMask seen = 0;
+    const char* key = nullptr;
+    size_t keyLength = 0;
+
+    parser.beginObject();
+    while (parser.nextKey(key, keyLength))
+    {
+        size_t frame = headerField(key, keyLength);
+        if (frame < HEADER_FIELDS)
+        {
+            // The frame comes first, a repeated or late frame field is left to ArduinoJson
+            unsigned int value = 0;
+            parser.read(value);
+            if (fields || (found & (1u << frame)))
+            {
+                return false;
+            }
+            setHeaderField(header, frame, value);
+            found |= 1u << frame;
+            continue;
+        }
+
+        if (!fields)
+        {
+            // The type is known once the first specific field is reached
+            fields = (found & HEADER_TYPE) ? target(header.msgType, context) : nullptr;
+            if (!fields)
+            {
+                return false;
+            }
+            table = RegisteredMessages::fields(header.msgType);
+        }
+        size_t i = table.find(key, keyLength);
+        MessageFieldMask bit = (MessageFieldMask)1 << i;
+        if (i >= table.count || !(projection & bit))
+        {
+            parser.skipValue();
+            continue;
+        }
+        if (seen & bit)
+        {
+            return false;
+        }
+        parser.readField(table.fields[i], fields);
+        seen |= bit;
+    }
+    parser.endObject();
+
+    if (!fields && !parser.failed() && (found & HEADER_TYPE))
+    {
+        // a message type without specific fields
+        fields = target(header.msgType, context);
+        table = RegisteredMessages::fields(header.msgType);
+    }
+    // Missing fields are converted by ArduinoJson like before
+    MessageFieldMask required = table.count < 8 * sizeof(MessageFieldMask) ? ((MessageFieldMask)1 << table.count) - 1 : MESSAGE_FIELDS_ALL;
+    return !parser.failed() && fields && found == HEADER_COMPLETE && (seen & projection & required) == (projection & required);
+}
+
+/**
+ * @brief Message translateFlatJson reads a payload into
+ * 
+ */
+struct FlatTarget
+{
+    const std::shared_ptr<Message>* into;   ///< message of decodeInto or nullptr
+    std::shared_ptr<Message> message;       ///< message of the payload type, set by flatTarget
+    void* staging;                          ///< RegisteredMessages::FIELDS_SIZE bytes for the fields of into
+};
+
+/**
+ * @brief Record target of translateFlatJson, like obtainMessage without reporting unknown types
+ * 
+ * The document path the payload falls back to reports them once.
+ * 
+ * @param type 
+ * @param context - FlatTarget
+ * @return void* 
+ */
+static void* flatTarget(Message::MessageType type, void* context)
+{
+    FlatTarget& target = *static_cast<FlatTarget*>(context);
+    const std::shared_ptr<Message>& into = *target.into;
+    if (!into)
+    {
+        target.message = RegisteredMessages::create(type);
+        return target.message ? RegisteredMessages::fieldsOf(*target.message) : nullptr;
+    }
+    if (into->msgType != type)
+    {
+        return nullptr;
+    }
+    // An existing message is overwritten only if the payload is read completely
+    target.message = into;
+    return RegisteredMessages::stageFields(type, target.staging);
+}
+
+std::shared_ptr<Message> Message::translateFlatJson(const char* payload, size_t length, MessageFieldMask projection, const std::shared_ptr<Message>& into)
+{
+    MESSAGE_FUNCCALLln("Message::translateFlatJson(const char*, size_t, MessageFieldMask, const std::shared_ptr<Message>&)");
+    alignas(std::max_align_t) unsigned char staging[RegisteredMessages::FIELDS_SIZE];
+    FlatTarget target = {&into, nullptr, staging};
+    MessageHeader header;
+    if (!readFlatJson(payload, length, header, &flatTarget, &target, projection))
+    {
+        return nullptr;
+    }
+    std::shared_ptr<Message> retVal = target.message;
+    if (into)
+    {
+        RegisteredMessages::commitFields(*retVal, staging);
+    }
+    retVal->msgId = header.msgId;
+    retVal->msgType = header.msgType;
+    retVal->msgLength = header.msgLength;
+    retVal->msgConsignor = header.msgConsignor;
+    MESSAGE_INFOln("Parsed flat JSON message");
+    return retVal;
+}
+
+std::shared_ptr<Message> Message::translateBinaryToStruct(const uint8_t* payload, size_t length, DecodeStatus& status, MessageFieldMask projection, const std::shared_ptr<Message>& into)
+{
+    MESSAGE_FUNCCALLln("Message::translateBinaryToStruct(const uint8_t*, size_t, DecodeStatus&, MessageFieldMask, const std::shared_ptr<Message>&)");
+    // Read the frame once, its type selects the class the fields are read into
+    MessageReader reader(payload, length);
+    MessageHeader header;
+    readFrame(reader, header);
+    if (reader.failed())
+    {
+        MESSAGE_WARNINGln("Binary message truncated");
+        status = DecodeStatus::Malformed;
+        if (into)
+        {
+            // set msgId to zero, zero means errorId
+            into->msgId = 0;
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Message> retVal = obtainMessage(header.msgType, into);
+    status = retVal ? DecodeStatus::Ok : into ? DecodeStatus::WrongType : DecodeStatus::UnknownType;
+    if (retVal)
+    {
+        if (projection != MESSAGE_FIELDS_ALL)
+        {
+            RegisteredMessages::resetFields(*retVal);
+        }
+        reader.project(projection);
+        reader.fields(RegisteredMessages::fields(header.msgType), RegisteredMessages::fieldsOf(*retVal));
+        reader.endObject();
+        retVal->msgId = header.msgId;
+        retVal->msgLength = header.msgLength;
+        retVal->msgConsignor = header.msgConsignor;
+        if (reader.failed())
+        {
+            MESSAGE_WARNINGln("Binary message truncated");
+
+            // set msgId to zero, zero means errorId
+            retVal->msgId = 0;
+            status = DecodeStatus::Malformed;
+        }
+    }
+    return retVal;
+}
+
+void Message::parseJSONToStruct(JsonObjectConst doc, DeserializationError error)
+{
+    MESSAGE_FUNCCALLln("Message::parseJSONToStruct(JsonObjectConst, DeserializationError)");
+    if (error)
+    {
+        MESSAGE_WARNING("Deserialization failed: ");
+        MESSAGE_WARNINGln(error.c_str());
+
+        // set msgId to zero, zero means errorId
+        this->msgId = 0;
+    }
+    else
+    {
+        this->readJson(doc);
+    }
+}
+
+bool Message::readJson(JsonObjectConst doc, MessageFieldMask projection)
+{
+    if (projection != MESSAGE_FIELDS_ALL)
+    {
+        RegisteredMessages::resetFields(*this);
+    }
+    MessageReader reader(doc);
+    reader.project(projection);
+    this->readMessage(reader);
+    if (reader.failed())
+    {
+        MESSAGE_WARNINGln("Message field exceeds its capacity");
+
+        // set msgId to zero, zero means errorId
+        this->msgId = 0;
+        return false;
+    }
+    return true;
+}
+
+void Message::readMessage(MessageReader& reader)
+{
+    // Parse message frame
+    MessageHeader header;
+    readFrame(reader, header);
+    this->msgId = header.msgId;
+    this->msgType = header.msgType;
+    this->msgLength = header.msgLength;
+    this->msgConsignor = header.msgConsignor;
+
+    // Parse specific message
+    this->readFields(reader);
+    reader.endObject();
+}
+
+String Message::translateStructToString(std::shared_ptr<Message> object)
+{
+    MESSAGE_FUNCCALLln("Message::translateStructToString(std::shared_ptr<Message>)");
+    String retVal = object->parseStructToString();
+    return retVal;
+}
+
+void Message::writeMessage(MessageWriter& writer) const
 {
+    // A MessagePack map starts with its size, count the fields in a dry run
+    size_t fields = 0;
+    if (writer.wireFormat() == WireFormat::MsgPack)
+    {
+        MessageWriter counter;
+        this->writeFields(counter);
+        fields = 4 + counter.fields();
+    }
+
+    // Write message frame
+    writer.beginObject(fields);
+    writer.field("msgId", this->msgId);
+    writer.field("msgType", (unsigned int)this->msgType);
+    writer.field("msgLength", this->msgLength);
+    writer.field("msgConsignor", (unsigned int)this->msgConsignor);
+
+    // Write specific message
+    this->writeFields(writer);
+    writer.endObject();
 }
 
+size_t Message::serialize(char* buffer, size_t size, WireFormat format) const
+{
+    MESSAGE_FUNCCALLln("Message::serialize(char*, size_t, WireFormat)");
+    uint32_t started = MessageMetrics::start();
+    MessageWriter writer(buffer, size, format);
+    this->writeMessage(writer);
+    MessageMetrics::recordEncode(this->msgType, writer.length(), !writer.overflowed(), started);
+    return writer.overflowed() ? 0 : writer.length();
+}
 
-std::shared_ptr<Message> Message::translateJsonToStruct(const char* payload, unsigned int length)
+size_t Message::serialize(Print& output, WireFormat format) const
 {
-    DBFUNCCALLln("Message::translateJsonToStruct(const char*, unsigned int)");
-    // Deserialize json object to json document
-    DynamicJsonDocument tempJson(length);
-    DeserializationError error = deserializeJson(tempJson, payload);
-    
-    // Generate pointer to return dynamic object
-    std::shared_ptr<Message> retVal (nullptr);
-   
-    // switch to correct msgtype to activate polymorphism
-    switch (tempJson["msgType"].as<unsigned int>())
+    MESSAGE_FUNCCALLln("Message::serialize(Print&, WireFormat)");
+    uint32_t started = MessageMetrics::start();
+    MessageWriter writer(output, format);
+    this->writeMessage(writer);
+    MessageMetrics::recordEncode(this->msgType, writer.length(), true, started);
+    return writer.length();
+}
+
+size_t Message::measure(WireFormat format) const
+{
+    MESSAGE_FUNCCALLln("Message::measure(WireFormat)");
+    MessageWriter counter(format);
+    this->writeMessage(counter);
+    return counter.length();
+}
+
+void Message::updateLength()
+{
+    MESSAGE_FUNCCALLln("Message::updateLength()");
+    // msgLength is part of the message, so repeat until its digits are stable
+    // msgLength always holds the length of the JSON encoding
+    unsigned int length = 0;
+    do
     {
-    case (unsigned int)MessageType::Package:
-        {
-            retVal = std::make_shared<PackageMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-       
-    case (unsigned int)MessageType::Error:
-        {
-            retVal = std::make_shared<ErrorMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SBAvailable:
-        {
-            retVal = std::make_shared<SBAvailableMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SBPosition:
-        {
-            retVal = std::make_shared<SBPositionMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SBState:
-        {
-            retVal = std::make_shared<SBStateMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SBToSVHandshake:
-        {
-            retVal = std::make_shared<SBToSVHandshakeMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }        
-    case (unsigned int)MessageType::SVAvailable:
-        {
-            retVal = std::make_shared<SVAvailableMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }        
-    case (unsigned int)MessageType::SVPosition:
-        {
-            retVal = std::make_shared<SVPositionMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SVState:
-        {
-            retVal = std::make_shared<SVStateMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SBToSOHandshake:
-        {
-            retVal = std::make_shared<SBToSOHandshakeMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SOPosition:
-        {
-            retVal = std::make_shared<SOPositionMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SOState:
-        {
-            retVal = std::make_shared<SOStateMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
-        }
-    case (unsigned int)MessageType::SOInit:
+        this->msgLength = length;
+        length = (unsigned int)this->measure();
+    } while (length != this->msgLength);
+}
+
+String Message::parseStructToString()
+{
+    MESSAGE_FUNCCALLln("Message::parseStructToString()");
+    // Measure first so the string is allocated exactly once
+    uint32_t started = MessageMetrics::start();
+    String retVal;
+    retVal.reserve(this->measure());
+    MessageWriter writer(retVal);
+    this->writeMessage(writer);
+    MessageMetrics::recordEncode(this->msgType, writer.length(), true, started);
+    return retVal;
+}
+
+
+//======================RECORD===========================================================
+//=======================================================================================
+
+/**
+ * @brief Read the frame and the fields of a record from a binary payload or a document
+ * 
+ * @param reader 
+ * @param header - set to the frame
+ * @param target 
+ * @param context 
+ * @param projection 
+ * @return void* - fields returned by target, nullptr if the frame failed or the type was not accepted
+ */
+static void* readRecord(MessageReader& reader, MessageHeader& header, Message::RecordTarget target, void* context, MessageFieldMask projection)
+{
+    readFrame(reader, header);
+    void* fields = reader.failed() ? nullptr : target(header.msgType, context);
+    if (fields)
+    {
+        reader.project(projection);
+        reader.fields(RegisteredMessages::fields(header.msgType), fields);
+        reader.endObject();
+    }
+    return fields;
+}
+
+/**
+ * @brief Write the frame and the fields of a record
+ * 
+ * @param writer 
+ * @param header - its msgType selects the field table
+ * @param fields 
+ */
+static void writeRecord(MessageWriter& writer, const MessageHeader& header, const void* fields)
+{
+    // Every field of the table is written, so the MessagePack map size is known without a dry run
+    MessageFieldTable table = RegisteredMessages::fields(header.msgType);
+    writer.beginObject(4 + table.count);
+    writer.field("msgId", header.msgId);
+    writer.field("msgType", (unsigned int)header.msgType);
+    writer.field("msgLength", header.msgLength);
+    writer.field("msgConsignor", (unsigned int)header.msgConsignor);
+    writer.fields(table, fields);
+    writer.endObject();
+}
+
+DecodeStatus Message::decodeRecord(const char* payload, size_t length, MessageHeader& header, RecordTarget target, void* context, MessageFieldMask projection)
+{
+    MESSAGE_FUNCCALLln("Message::decodeRecord(const char*, size_t, MessageHeader&, RecordTarget, void*, MessageFieldMask)");
+    uint32_t started = MessageMetrics::start();
+    header = MessageHeader();
+    DecodeStatus status = DecodeStatus::Ok;
+    WireFormat format = detectWireFormat(payload, length);
+    if (format == WireFormat::Binary)
+    {
+        MessageReader reader((const uint8_t*)payload, length);
+        void* fields = readRecord(reader, header, target, context, projection);
+        if (reader.failed())
         {
-            retVal = std::make_shared<SOInitMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-            break;
+            MESSAGE_WARNINGln("Binary message truncated");
+            status = DecodeStatus::Malformed;
         }
-    case (unsigned int)MessageType::SOBuffer:
+        else if (!fields)
         {
-            retVal = std::make_shared<BufferMessage>();
-            retVal->parseJSONToStruct(tempJson, error);
-        }
-    default:
-        {   
-        DBWARNING("Translation failed");
-        break;
+            status = DecodeStatus::UnknownType;
         }
     }
-    return retVal;
+    else if (!MESSAGE_FLAT_JSON || format != WireFormat::Json || !readFlatJson(payload, length, header, target, context, projection))
+    {
+        header = MessageHeader();
+        status = decodeRecordDocument(payload, length, format, header, target, context, projection);
+    }
+
+    if (status == DecodeStatus::UnknownType)
+    {
+        MESSAGE_WARNINGln("Translation failed");
+    }
+    else if (status != DecodeStatus::Ok)
+    {
+        // set msgId to zero, zero means errorId
+        header.msgId = 0;
+    }
+    MessageMetrics::recordDecode(status == DecodeStatus::UnknownType ? MessageType::DEFAULTMESSAGETYPE : header.msgType, length, status == DecodeStatus::Ok, started);
+    return status;
 }
 
-String Message::translateStructToString(std::shared_ptr<Message> object)
+__attribute__((noinline))
+DecodeStatus Message::decodeRecordDocument(const char* payload, size_t length, WireFormat format, MessageHeader& header, RecordTarget target, void* context, MessageFieldMask projection)
 {
-    DBFUNCCALLln("Message::translateStructToString(std::shared_ptr<Message>)");
-    String retVal = object->parseStructToString();
-    return retVal;
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> tempJson;
+    DeserializationError error = deserializePayload(payload, length, format, tempJson, projection);
+    MessageReader reader(tempJson.as<JsonObjectConst>());
+    if (error)
+    {
+        MESSAGE_WARNING("Deserialization failed: ");
+        MESSAGE_WARNINGln(error.c_str());
+        // The frame of a partial document still counts the decode for its type
+        readFrame(reader, header);
+        return error == DeserializationError::NoMemory ? DecodeStatus::NoMemory : DecodeStatus::Malformed;
+    }
+    void* fields = readRecord(reader, header, target, context, projection);
+    if (reader.failed())
+    {
+        MESSAGE_WARNINGln("Message field exceeds its capacity");
+        return fields ? DecodeStatus::Invalid : DecodeStatus::Malformed;
+    }
+    return fields ? DecodeStatus::Ok : DecodeStatus::UnknownType;
+}
+
+size_t Message::serializeRecord(const MessageHeader& header, const void* fields, char* buffer, size_t size, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::serializeRecord(const MessageHeader&, const void*, char*, size_t, WireFormat)");
+    uint32_t started = MessageMetrics::start();
+    MessageWriter writer(buffer, size, format);
+    writeRecord(writer, header, fields);
+    MessageMetrics::recordEncode(header.msgType, writer.length(), !writer.overflowed(), started);
+    return writer.overflowed() ? 0 : writer.length();
+}
+
+size_t Message::serializeRecord(const MessageHeader& header, const void* fields, Print& output, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::serializeRecord(const MessageHeader&, const void*, Print&, WireFormat)");
+    uint32_t started = MessageMetrics::start();
+    MessageWriter writer(output, format);
+    writeRecord(writer, header, fields);
+    MessageMetrics::recordEncode(header.msgType, writer.length(), true, started);
+    return writer.length();
 }
 
+size_t Message::measureRecord(const MessageHeader& header, const void* fields, WireFormat format)
+{
+    MESSAGE_FUNCCALLln("Message::measureRecord(const MessageHeader&, const void*, WireFormat)");
+    MessageWriter counter(format);
+    writeRecord(counter, header, fields);
+    return counter.length();
+}
 
 //======================SPEZCLASS========================================================
 //=======================================================================================
 
+/**
+ * @brief Copy a String into a text field in setMessage
+ * 
+ * A longer value is truncated to the capacity of the field and reported.
+ * 
+ * @param field 
+ * @param value 
+ */
+template <size_t N>
+static void setText(FixedString<N>& field, const String& value)
+{
+    if (!field.assign(value.c_str(), value.length()))
+    {
+        MESSAGE_WARNINGln("Message field truncated, increase its length");
+    }
+}
+
 
 //======================PackageMessage===================================================
 //=======================================================================================
 
 PackageMessage::PackageMessage()
 {
-    DBFUNCCALLln("PackageMessage::PackageMessage()");
-    this->msgType = MessageType::Package;
+    MESSAGE_FUNCCALLln("PackageMessage::PackageMessage()");
+    this->msgType = TYPE;
 }
 
 PackageMessage::~PackageMessage()
 {
-    DBFUNCCALLln("PackageMessage::~PackageMessage()");    
+    MESSAGE_FUNCCALLln("PackageMessage::~PackageMessage()");    
 }
 
-void PackageMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error) 
+void PackageMessage::readFields(MessageReader& reader)
 {
-    
-    DBFUNCCALLln("PackageMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed package message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->packageId = doc["packageId"].as<unsigned int>();
-        this->cargo = doc["cargo"].as<String>();
-        this->targetDest = doc["targetDest"].as<String>();
-        this->targetReg = doc["targetReg"].as<String>();
-    }
-    
+    MESSAGE_FUNCCALLln("PackageMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed package message");
 }
 
-String PackageMessage::parseStructToString()
+void PackageMessage::writeFields(MessageWriter& writer) const
 {
-
-    DBFUNCCALLln("PackageMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"packageId\":\"" + (String)this->packageId + "\",\"cargo\":\"" + this->cargo + "\",\"targetDest\":\"" + this->targetDest + "\",\"targetReg\":\"" + this->targetReg + "\"}";
-    return tempString;
+    MESSAGE_FUNCCALLln("PackageMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 
 void PackageMessage::setMessage(unsigned int messageId, Consignor messageConsignor, unsigned int messagePackageId, String messageCargo, String messageTargetDest, String messageTargetReg)
 {
-    DBFUNCCALLln("PackageMessage::setMessage(unsigned int, Consignor, unsigned int, String, String, String)")
+    MESSAGE_FUNCCALLln("PackageMessage::setMessage(unsigned int, Consignor, unsigned int, String, String, String)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->packageId = messagePackageId;
     this->cargo = messageCargo;
-    this->targetDest = messageTargetDest;
+    setText(this->targetDest, messageTargetDest);
     this->targetReg = messageTargetReg;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 
@@ -211,56 +1270,36 @@ void PackageMessage::setMessage(unsigned int messageId, Consignor messageConsign
 
 ErrorMessage::ErrorMessage()
 {
-    DBFUNCCALLln("ErrorMessage::ErrorMessage()");
-    this->msgType = MessageType::Error;
+    MESSAGE_FUNCCALLln("ErrorMessage::ErrorMessage()");
+    this->msgType = TYPE;
 }
 
 ErrorMessage::~ErrorMessage()
 {
-    DBFUNCCALLln("ErrorMessage::~ErrorMessage()");
+    MESSAGE_FUNCCALLln("ErrorMessage::~ErrorMessage()");
 }
 
-void ErrorMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void ErrorMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("ErrorMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed error message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->error = doc["error"].as<bool>();
-        this->token = doc["token"].as<bool>();
-    }    
+    MESSAGE_FUNCCALLln("ErrorMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed error message");
 }
 
-String ErrorMessage::parseStructToString()
+void ErrorMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("ErrorMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"error\":\"" + (String)this->error + "\",\"token\":\"" + (String)this->token + "\"}";
-    return tempString;
+    MESSAGE_FUNCCALLln("ErrorMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void ErrorMessage::setMessage(unsigned int messageId, Consignor messageConsignor, bool messageError, bool messageToken)
 {
-    DBFUNCCALLln("ErrorMessage::setMessage(unsigned int, Consignor, bool, bool)");
+    MESSAGE_FUNCCALLln("ErrorMessage::setMessage(unsigned int, Consignor, bool, bool)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->error = messageError;
     this->token = messageToken;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SBAvailableMessage===============================================
@@ -268,114 +1307,73 @@ void ErrorMessage::setMessage(unsigned int messageId, Consignor messageConsignor
 
 SBAvailableMessage::SBAvailableMessage()
 {
-    DBFUNCCALLln("SBAvailableMessage::SBAvailableMessage()");
-    this->msgType = MessageType::SBAvailable;
+    MESSAGE_FUNCCALLln("SBAvailableMessage::SBAvailableMessage()");
+    this->msgType = TYPE;
 }
 
 SBAvailableMessage::~SBAvailableMessage()
 {
-    DBFUNCCALLln("SBAvailableMessage::~SBAvailableMessage()");
+    MESSAGE_FUNCCALLln("SBAvailableMessage::~SBAvailableMessage()");
 }
 
-void SBAvailableMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SBAvailableMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SBAvailableMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartbox available message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->sector = doc["sector"].as<String>();
-        this->line = doc["line"].as<int>();
-        this->targetReg = doc["targetReg"].as<String>();
-    }           
+    MESSAGE_FUNCCALLln("SBAvailableMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartbox available message");
 }
 
-String SBAvailableMessage::parseStructToString()
+void SBAvailableMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SBAvailableMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"sector\":\"" + this->sector + "\",\"line\":\"" + (String)this->line + "\",\"targetReg\":\"" + this->targetReg + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SBAvailableMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SBAvailableMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine, String messageTargetReg)
 {
-    DBFUNCCALLln("SBAvailableMessage::setMessage(unsigned int, Consignor, String, int, String)")
+    MESSAGE_FUNCCALLln("SBAvailableMessage::setMessage(unsigned int, Consignor, String, int, String)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->sector = messageSector;
     this->line = messageLine;
     this->targetReg = messageTargetReg;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SBPositionMessage================================================
 //=======================================================================================
 SBPositionMessage::SBPositionMessage()
 {
-    DBFUNCCALLln("SBPositionMessage::SBPositionMessage()");
-    this->msgType = MessageType::SBPosition;
+    MESSAGE_FUNCCALLln("SBPositionMessage::SBPositionMessage()");
+    this->msgType = TYPE;
 }
 
 SBPositionMessage::~SBPositionMessage()
 {
-    DBFUNCCALLln("SBPositionMessage::~SBPositionMessage()");
+    MESSAGE_FUNCCALLln("SBPositionMessage::~SBPositionMessage()");
 }
 
-void SBPositionMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SBPositionMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SBPositionMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartbox position message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->sector = doc["sector"].as<String>();
-        this->line = doc["line"].as<int>();
-    }       
+    MESSAGE_FUNCCALLln("SBPositionMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartbox position message");
 }
 
-String SBPositionMessage::parseStructToString()
+void SBPositionMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SBPositionMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"sector\":\"" + this->sector + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SBPositionMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SBPositionMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine)
 {
-    DBFUNCCALLln("SBPositionMessage::setMessage(unsigned int, Consignor, String, int)");
+    MESSAGE_FUNCCALLln("SBPositionMessage::setMessage(unsigned int, Consignor, String, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->sector = messageSector;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 
@@ -384,54 +1382,35 @@ void SBPositionMessage::setMessage(unsigned int messageId, Consignor messageCons
 
 SBStateMessage::SBStateMessage()
 {
-    DBFUNCCALLln("SBStateMessage::SBStateMessage()");
-    this->msgType = MessageType::SBState;
+    MESSAGE_FUNCCALLln("SBStateMessage::SBStateMessage()");
+    this->msgType = TYPE;
 }
 
 SBStateMessage::~SBStateMessage()
 {
-    DBFUNCCALLln("SBStateMessage::~SBStateMessage()");
+    MESSAGE_FUNCCALLln("SBStateMessage::~SBStateMessage()");
 }
 
-void SBStateMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SBStateMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SBStateMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartbox state message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->state = doc["state"].as<String>();
-    }   
+    MESSAGE_FUNCCALLln("SBStateMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartbox state message");
 }
 
-String SBStateMessage::parseStructToString()
+void SBStateMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SBStateMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)(this->msgLength) + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"state\":\"" + (this->state) +"\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SBStateMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SBStateMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageState)
 {
-    DBFUNCCALLln("SBStateMessage::setMessage(unsigned int, Consignor, String)");
+    MESSAGE_FUNCCALLln("SBStateMessage::setMessage(unsigned int, Consignor, String)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->state = messageState;
-    this->msgLength = (unsigned int)sizeof(this);
+    this->updateLength();
 }
 
 //======================SBToSVHandshakeMessage===========================================
@@ -439,62 +1418,40 @@ void SBStateMessage::setMessage(unsigned int messageId, Consignor messageConsign
 
 SBToSVHandshakeMessage::SBToSVHandshakeMessage()
 {
-    DBFUNCCALLln("SBToSVHandshakeMessage::SBToSVHandshakeMessage()");
-    this->msgType = MessageType::SBToSVHandshake;
+    MESSAGE_FUNCCALLln("SBToSVHandshakeMessage::SBToSVHandshakeMessage()");
+    this->msgType = TYPE;
 }
 
 SBToSVHandshakeMessage::~SBToSVHandshakeMessage()
 {
-    DBFUNCCALLln("SBToSVHandshakeMessage::~SBToSVHandshakeMessage()");
+    MESSAGE_FUNCCALLln("SBToSVHandshakeMessage::~SBToSVHandshakeMessage()");
 }
 
 
-void SBToSVHandshakeMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SBToSVHandshakeMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SBToSVHandshakeMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartbox to smartvehicle handshake message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->reck = doc["reck"].as<String>();
-        this->ack = doc["ack"].as<String>();
-        this->cargo = doc["cargo"].as<String>();
-        this->line = doc["line"].as<int>();
-    }       
+    MESSAGE_FUNCCALLln("SBToSVHandshakeMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartbox to smartvehicle handshake message");
 }
 
 
-String SBToSVHandshakeMessage::parseStructToString()
+void SBToSVHandshakeMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SBToSVHandshakeMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"reck\":\"" + this->reck + "\",\"ack\":\"" + this->ack + "\",\"cargo\":\"" + this->cargo + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SBToSVHandshakeMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SBToSVHandshakeMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageReck, String messageAck, String messageCargo, int messageLine)
 {
-    DBFUNCCALLln("SBToSVHandshakeMessage::setMessage(unsigned int, Consignor, String, String, String, int)");
+    MESSAGE_FUNCCALLln("SBToSVHandshakeMessage::setMessage(unsigned int, Consignor, String, String, String, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
-    this->reck = messageReck;
-    this->ack = messageAck;
+    setText(this->reck, messageReck);
+    setText(this->ack, messageAck);
     this->cargo = messageCargo;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SVAvailableMessage===============================================
@@ -502,56 +1459,36 @@ void SBToSVHandshakeMessage::setMessage(unsigned int messageId, Consignor messag
 
 SVAvailableMessage::SVAvailableMessage()
 {
-    DBFUNCCALLln("SVAvailableMessage::SVAvailableMessage()");
-    this->msgType = MessageType::SVAvailable;
+    MESSAGE_FUNCCALLln("SVAvailableMessage::SVAvailableMessage()");
+    this->msgType = TYPE;
 }
 
 SVAvailableMessage::~SVAvailableMessage()
 {
-    DBFUNCCALLln("SVAvailableMessage::~SVAvailableMessage()");
+    MESSAGE_FUNCCALLln("SVAvailableMessage::~SVAvailableMessage()");
 }
 
-void SVAvailableMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SVAvailableMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SVAvailableMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartvehicle available message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->sector = doc["sector"].as<String>();
-        this->line = doc["line"].as<int>();
-    }       
+    MESSAGE_FUNCCALLln("SVAvailableMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartvehicle available message");
 }
 
-String SVAvailableMessage::parseStructToString()
+void SVAvailableMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SVAvailableMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"sector\":\"" + this->sector + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SVAvailableMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SVAvailableMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine)
 {
-    DBFUNCCALLln("SVAvailableMessage::setMessage(unsigned int, Consignor, String, int)");
+    MESSAGE_FUNCCALLln("SVAvailableMessage::setMessage(unsigned int, Consignor, String, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->sector = messageSector;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SVPositionMessage================================================
@@ -559,56 +1496,36 @@ void SVAvailableMessage::setMessage(unsigned int messageId, Consignor messageCon
 
 SVPositionMessage::SVPositionMessage()
 {
-    DBFUNCCALLln("SVPositionMessage::SVPositionMessage()");
-    this->msgType = MessageType::SVPosition;
+    MESSAGE_FUNCCALLln("SVPositionMessage::SVPositionMessage()");
+    this->msgType = TYPE;
 }
 
 SVPositionMessage::~SVPositionMessage()
 {
-    DBFUNCCALLln("SVPositionMessage::~SVPositionMessage()");
+    MESSAGE_FUNCCALLln("SVPositionMessage::~SVPositionMessage()");
 }
 
-void SVPositionMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void SVPositionMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("SVPositionMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartvehicle position message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->sector = doc["sector"].as<String>();
-        this->line = doc["line"].as<int>();
-    }
+    MESSAGE_FUNCCALLln("SVPositionMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartvehicle position message");
 }
 
-String SVPositionMessage::parseStructToString()
+void SVPositionMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SVPositionMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"sector\":\"" + this->sector + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SVPositionMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SVPositionMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine)
 {
-    DBFUNCCALLln("SVPositionMessage::setMessage(unsigned int, Consignor, String, int)");
+    MESSAGE_FUNCCALLln("SVPositionMessage::setMessage(unsigned int, Consignor, String, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->sector = messageSector;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SVStateMessage===================================================
@@ -616,54 +1533,35 @@ void SVPositionMessage::setMessage(unsigned int messageId, Consignor messageCons
 
 SVStateMessage::SVStateMessage()
 {
-    DBFUNCCALLln("SVStateMessage::SVStateMessage()");
-    this->msgType = MessageType::SVState;
+    MESSAGE_FUNCCALLln("SVStateMessage::SVStateMessage()");
+    this->msgType = TYPE;
 }
 
 SVStateMessage::~SVStateMessage()
 {
-    DBFUNCCALLln("SVStateMessage::~SVStateMessage()");
+    MESSAGE_FUNCCALLln("SVStateMessage::~SVStateMessage()");
 }
 
-void SVStateMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
-{   
-    DBFUNCCALLln("SVStateMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartvehicle state message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->state = doc["state"].as<String>();
-    }
+void SVStateMessage::readFields(MessageReader& reader)
+{
+    MESSAGE_FUNCCALLln("SVStateMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartvehicle state message");
 }
 
-String SVStateMessage::parseStructToString()
+void SVStateMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SVStateMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"state\":\"" + this->state + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SVStateMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SVStateMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageState)
 {
-    DBFUNCCALLln("SVStateMessage::setMessage(unsigned int, Consignor, String)");
+    MESSAGE_FUNCCALLln("SVStateMessage::setMessage(unsigned int, Consignor, String)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->state = messageState;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 
@@ -672,62 +1570,39 @@ void SVStateMessage::setMessage(unsigned int messageId, Consignor messageConsign
 
 SBToSOHandshakeMessage::SBToSOHandshakeMessage()
 {
-    DBFUNCCALLln("SBToSOHandshakeMessage::SBToSOHandshakeMessage()");
-    this->msgType = MessageType::SBToSOHandshake;
+    MESSAGE_FUNCCALLln("SBToSOHandshakeMessage::SBToSOHandshakeMessage()");
+    this->msgType = TYPE;
 }
 
 SBToSOHandshakeMessage::~SBToSOHandshakeMessage()
 {
-    DBFUNCCALLln("SBToSOHandshakeMessage::~SBToSOHandshakeMessage()");
+    MESSAGE_FUNCCALLln("SBToSOHandshakeMessage::~SBToSOHandshakeMessage()");
 }
 
-void SBToSOHandshakeMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
-{   
-    DBFUNCCALLln("SBToSOHandshakeMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed smartbox to sortic handshake message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->req = doc["req"].as<String>();
-        this->ack = doc["ack"].as<String>();
-        this->cargo = doc["cargo"].as<String>();
-        this->targetReg = doc["targetReg"].as<String>();
-        this->line = doc["line"].as<int>();
-    }
+void SBToSOHandshakeMessage::readFields(MessageReader& reader)
+{
+    MESSAGE_FUNCCALLln("SBToSOHandshakeMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed smartbox to sortic handshake message");
 }
 
-String SBToSOHandshakeMessage::parseStructToString()
+void SBToSOHandshakeMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SBToSOHandshakeMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"reck\":\"" + this->req + "\",\"ack\":\"" + this->ack + "\",\"cargo\":\"" + this->cargo + "\",\"targetReg\":\"" + this->targetReg + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SBToSOHandshakeMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SBToSOHandshakeMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageReq, String messageAck, String messageCargo, String messageTargetReg, int messageLine)
 {
-    DBFUNCCALLln("SBToSOHandshakeMessage::setMessage(unsigned int, Consignor, String, String, String, String, int)");
+    MESSAGE_FUNCCALLln("SBToSOHandshakeMessage::setMessage(unsigned int, Consignor, String, String, String, String, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
-    this->req = messageReq;
-    this->ack = messageAck;
+    setText(this->req, messageReq);
+    setText(this->ack, messageAck);
     this->cargo = messageCargo;
     this->targetReg = messageTargetReg;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SOPositionMessage================================================
@@ -735,55 +1610,36 @@ void SBToSOHandshakeMessage::setMessage(unsigned int messageId, Consignor messag
 
 SOPositionMessage::SOPositionMessage()
 {
-    DBFUNCCALLln("SOPositionMessage::SOPositionMessage()");
-    this->msgType = MessageType::SOPosition;
+    MESSAGE_FUNCCALLln("SOPositionMessage::SOPositionMessage()");
+    this->msgType = TYPE;
 }
 
 SOPositionMessage::~SOPositionMessage()
 {
-    DBFUNCCALLln("SOPositionMessage::~SOPositionMessage()");
+    MESSAGE_FUNCCALLln("SOPositionMessage::~SOPositionMessage()");
 }
 
 
-void SOPositionMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
-{   
-    DBFUNCCALLln("SOPositionMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed sortic position message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->line = doc["line"].as<int>();
-    }
+void SOPositionMessage::readFields(MessageReader& reader)
+{
+    MESSAGE_FUNCCALLln("SOPositionMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed sortic position message");
 }
 
-String SOPositionMessage::parseStructToString()
+void SOPositionMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SOPositionMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"line\":\"" + (String)this->line + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SOPositionMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SOPositionMessage::setMessage(unsigned int messageId, Consignor messageConsignor, int messageLine)
 {
-    DBFUNCCALLln("SOPositionMessage::setMessage(unsigned int, Consignor, int)");
+    MESSAGE_FUNCCALLln("SOPositionMessage::setMessage(unsigned int, Consignor, int)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->line = messageLine;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SOStateMessage===================================================
@@ -791,54 +1647,35 @@ void SOPositionMessage::setMessage(unsigned int messageId, Consignor messageCons
 
 SOStateMessage::SOStateMessage()
 {
-    DBFUNCCALLln("SOStateMessage::SOStateMessage()");
-    this->msgType = MessageType::SOState;
+    MESSAGE_FUNCCALLln("SOStateMessage::SOStateMessage()");
+    this->msgType = TYPE;
 }
 
 SOStateMessage::~SOStateMessage()
 {
-    DBFUNCCALLln("SOStateMessage::~SOStateMessage()");
+    MESSAGE_FUNCCALLln("SOStateMessage::~SOStateMessage()");
 }
 
-void SOStateMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
-{   
-    DBFUNCCALLln("SOStateMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed sortic state message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->state = doc["state"].as<String>();
-    }
+void SOStateMessage::readFields(MessageReader& reader)
+{
+    MESSAGE_FUNCCALLln("SOStateMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed sortic state message");
 }
 
-String SOStateMessage::parseStructToString()
+void SOStateMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SOStateMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"state\":\"" + this->state + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SOStateMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SOStateMessage::setMessage(unsigned int messageId, Consignor messageConsignor, String messageState)
 {
-    DBFUNCCALLln("SOStateMessage::setMessage(unsigned int, Consignor, String)");
+    MESSAGE_FUNCCALLln("SOStateMessage::setMessage(unsigned int, Consignor, String)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->state = messageState;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================SOInitMessage====================================================
@@ -846,59 +1683,31 @@ void SOStateMessage::setMessage(unsigned int messageId, Consignor messageConsign
 
 SOInitMessage::SOInitMessage()
 {
-    DBFUNCCALLln("SOInitMessage::SOInitMessage()");
-    this->msgType = MessageType::SOInit;
+    MESSAGE_FUNCCALLln("SOInitMessage::SOInitMessage()");
+    this->msgType = TYPE;
 }
 
 SOInitMessage::~SOInitMessage()
 {
-    DBFUNCCALLln("SOInitMessage::~SOInitMessage()");
+    MESSAGE_FUNCCALLln("SOInitMessage::~SOInitMessage()");
 }
 
-void SOInitMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
-{   
-    DBFUNCCALLln("SOInitMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed sortic init message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->state = doc["state"].as<String>();
-        this->req = doc["req"].as<String>();
-        this->ack = doc["ack"].as<String>();
-        this->cargo = doc["cargo"].as<String>();
-        this->targetReg = doc["targetReg"].as<String>();
-        this->line = doc["line"].as<int>();
-        this->packageId = doc["packageId"].as<unsigned int>();
-        this->targetDest = doc["targetDest"].as<String>();
-        this->error = doc["error"].as<bool>();
-        this->token = doc["token"].as<bool>();
-    }
+void SOInitMessage::readFields(MessageReader& reader)
+{
+    MESSAGE_FUNCCALLln("SOInitMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed sortic init message");
 }
 
-String SOInitMessage::parseStructToString()
+void SOInitMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("SOInitMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"state\":\"" + this->state + "\",\"reck\":\"" + this->req + "\",\"ack\":\"" + this->ack + "\",\"cargo\":\"" + this->cargo + "\",\"targetReg\":\"" + this->targetReg + "\",\"line\":\"" + (String)this->line + "\",\"targetReg\":\"" + this->targetReg + "\",\"error\":\"" + (String)this->error + "\",\"token\":\"" + (String)this->token + "\"}";
-    return tempString;    
+    MESSAGE_FUNCCALLln("SOInitMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void SOInitMessage::setMessage()
 {
-    DBFUNCCALLln("SOInitMessage::setMessage()");
+    MESSAGE_FUNCCALLln("SOInitMessage::setMessage()");
     this->msgId = 0;
     this->msgConsignor = Consignor::SO1;
     this->state = "null";
@@ -911,7 +1720,7 @@ void SOInitMessage::setMessage()
     this->targetDest = "null";
     this->error = false;
     this->token = false;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
 
 //======================BufferMessage===================================================
@@ -919,54 +1728,34 @@ void SOInitMessage::setMessage()
 
 BufferMessage::BufferMessage()
 {
-    DBFUNCCALLln("BufferMessage::BufferMessage()");
-    this->msgType = MessageType::Error;
+    MESSAGE_FUNCCALLln("BufferMessage::BufferMessage()");
+    this->msgType = TYPE;
 }
 
 BufferMessage::~BufferMessage()
 {
-    DBFUNCCALLln("BufferMessage::~BufferMessage()");
+    MESSAGE_FUNCCALLln("BufferMessage::~BufferMessage()");
 }
 
-void BufferMessage::parseJSONToStruct(JsonDocument doc, DeserializationError error)
+void BufferMessage::readFields(MessageReader& reader)
 {
-    DBFUNCCALLln("BufferMessage::parseJSONToStruct(JsonDocument, DeserializationError)");
-    if (error)
-    {
-        DBWARNING("deserializeJson() failed: ");
-        DBWARNINGln(error.c_str());
-
-        // set msgId to zero, zero means errorId
-        this->msgId = 0;
-    }
-    else
-    {
-        DBINFO2ln("Parsed buffer message");
-        // Parse message frame
-        this->msgId = doc["msgId"].as<unsigned int>();
-        this->msgType = (MessageType)(doc["msgType"].as<unsigned int>());
-        this->msgLength = doc["msgLength"].as<unsigned int>();
-        this->msgConsignor = (Consignor)(doc["msgConsignor"].as<unsigned int>());
-
-        // Parse specific message
-        this->full = doc["full"].as<bool>();
-        this->cleared = doc["cleared"].as<bool>();
-    }    
+    MESSAGE_FUNCCALLln("BufferMessage::readFields(MessageReader&)");
+    reader.fields(Fields::table(), static_cast<Fields*>(this));
+    MESSAGE_INFOln("Parsed buffer message");
 }
 
-String BufferMessage::parseStructToString()
+void BufferMessage::writeFields(MessageWriter& writer) const
 {
-    DBFUNCCALLln("BufferMessage::parseStructToString()");
-    String tempString = "{\"msgId\":\"" + (String)this->msgId + "\",\"msgType\":\"" + (String)((unsigned int)(this->msgType)) + "\",\"msgLength\":\"" + (String)this->msgLength + "\",\"msgConsignor\":\"" + (String)((unsigned int)(this->msgConsignor)) + "\",\"full\":\"" + (String)this->full + "\",\"cleared\":\"" + (String)this->cleared + "\"}";
-    return tempString;
+    MESSAGE_FUNCCALLln("BufferMessage::writeFields(MessageWriter&)");
+    writer.fields(Fields::table(), static_cast<const Fields*>(this));
 }
 
 void BufferMessage::setMessage(unsigned int messageId, Consignor messageConsignor, bool messageFull, bool messageCleared)
 {
-    DBFUNCCALLln("BufferMessage::setMessage(unsigned int, Consignor, bool, bool)");
+    MESSAGE_FUNCCALLln("BufferMessage::setMessage(unsigned int, Consignor, bool, bool)");
     this->msgId = messageId;
     this->msgConsignor = messageConsignor;
     this->full = messageFull;
     this->cleared = messageCleared;
-    this->msgLength = sizeof(this);
+    this->updateLength();
 }
\ No newline at end of file
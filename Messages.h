@@ -14,8 +14,66 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <memory>
+#include <type_traits>
 
-#include "LogConfiguration.h"
+#include "MessageTrace.h"
+#include "MessageField.h"
+#include "MessageReader.h"
+#include "MessageWriter.h"
+
+/**
+ * @brief Maximum number of characters of a number sent as string, e.g. "-2147483648"
+ * 
+ * Numbers are written as native JSON numbers, but older firmware quotes them
+ * and the documents keep room for the copied strings.
+ * 
+ */
+#define MESSAGE_NUMBER_LENGTH 11
+
+/**
+ * @brief Default maximum number of characters of a string field
+ * 
+ * Can be overridden with a build flag, like the capacities of the single fields below.
+ * 
+ */
+#ifndef MESSAGE_STRING_LENGTH
+#define MESSAGE_STRING_LENGTH 24
+#endif
+
+/**
+ * @brief Maximum number of characters of the string fields
+ * 
+ * The fields store their characters inline. Longer values make the decode
+ * fail and are truncated with a warning by setMessage. state, sector, cargo
+ * and targetReg are symbols limited by MESSAGE_SYMBOL_LENGTH instead.
+ * 
+ */
+#ifndef MESSAGE_REGION_LENGTH
+#define MESSAGE_REGION_LENGTH MESSAGE_STRING_LENGTH         ///< targetDest
+#endif
+#ifndef MESSAGE_HANDSHAKE_LENGTH
+#define MESSAGE_HANDSHAKE_LENGTH MESSAGE_NUMBER_LENGTH      ///< req, reck and ack
+#endif
+
+/**
+ * @brief Pool bytes of one JSON member, the copied key and the copied value string
+ * 
+ */
+#define MESSAGE_JSON_MEMBER(key, valueLength) (sizeof(key) + (valueLength) + 1)
+#define MESSAGE_JSON_NUMBER(key) MESSAGE_JSON_MEMBER(key, MESSAGE_NUMBER_LENGTH)
+#define MESSAGE_JSON_STRING(key) MESSAGE_JSON_MEMBER(key, MESSAGE_STRING_LENGTH)
+
+/**
+ * @brief Maximum number of specific fields a deserialization filter can hold
+ * 
+ * JSON and MessagePack payloads of a known type are parsed with a filter
+ * built from the field table of the type, so unknown keys are never stored
+ * in the document. Types with more fields are parsed without filter.
+ * 
+ */
+#ifndef MESSAGE_FILTER_FIELDS
+#define MESSAGE_FILTER_FIELDS 12
+#endif
 
 
 /**
@@ -36,34 +94,16 @@ enum class Consignor
     SV3
 };
 
+struct MessageHeader;
+
 /**
  * @brief Abstract parent class to serialize messages
  * 
  */
 class Message
 {
-    private:
-
-
     public:
 
-    unsigned int msgId = 0;                                     ///< id of the message
-    MessageType msgType = MessageType::DEFAULTMESSAGETYPE;      ///< type of the message
-    unsigned int msgLength = 0;                                 ///< length of the message
-    Consignor msgConsignor = Consignor::DEFUALTCONSIGNOR;       ///< consignor of the message
-
-    /**
-     * @brief Construct a new Message object
-     * 
-     */
-    Message();
-
-    /**
-     * @brief Destroy the Message object
-     * 
-     */
-    virtual ~Message();
-
     /**
     * @brief Message type class holds all possible message types
     * 
@@ -87,17 +127,425 @@ class Message
         SOBuffer
     };
 
+    /**
+     * @brief Number of message types without DEFAULTMESSAGETYPE, keep it on the last type
+     * 
+     */
+    static constexpr size_t MESSAGE_TYPES = (size_t)MessageType::SOBuffer;
+
+    /**
+     * @brief Fields struct a record is decoded into, chosen once its type is read
+     * 
+     * @param type - msgType of the payload
+     * @param context - passed through by decodeRecord
+     * @return void* - fields struct of the type, the base of its table offsets, nullptr if the type is not accepted
+     */
+    typedef void* (*RecordTarget)(MessageType type, void* context);
+
+    private:
+
+    /**
+     * @brief Write the frame and the fields of the message
+     * 
+     * @param writer 
+     */
+    void writeMessage(MessageWriter& writer) const;
+
+    /**
+     * @brief Read the frame and the fields of the message
+     * 
+     * @param reader 
+     */
+    void readMessage(MessageReader& reader);
+
+    /**
+     * @brief Create an empty message of the given type
+     * 
+     * @param type 
+     * @return std::shared_ptr<Message> - nullptr if the type is unknown
+     */
+    static std::shared_ptr<Message> createMessage(MessageType type);
+
+    /**
+     * @brief Message to decode a payload of the given type into
+     * 
+     * @param type 
+     * @param into - message of decodeInto or nullptr
+     * @return std::shared_ptr<Message> - into if it has the type, a new message without into,
+     *                                     nullptr if the type is unknown or differs from into
+     */
+    static std::shared_ptr<Message> obtainMessage(MessageType type, const std::shared_ptr<Message>& into);
+
+    /**
+     * @brief Decode a binary payload
+     * 
+     * @param payload 
+     * @param length 
+     * @param status - set to the outcome of the decode
+     * @param projection 
+     * @param into - see obtainMessage
+     * @return std::shared_ptr<Message> 
+     */
+    static std::shared_ptr<Message> translateBinaryToStruct(const uint8_t* payload, size_t length, DecodeStatus& status, MessageFieldMask projection, const std::shared_ptr<Message>& into);
+
+    /**
+     * @brief Decode a payload in any wire format, decode adds the metrics
+     * 
+     * @param payload 
+     * @param length 
+     * @param document 
+     * @param status 
+     * @param projection 
+     * @param flat - try translateFlatJson first
+     * @param into - see obtainMessage
+     * @return std::shared_ptr<Message> 
+     */
+    static std::shared_ptr<Message> parsePayload(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection, bool flat, const std::shared_ptr<Message>& into);
+
+    /**
+     * @brief Fast path for flat JSON objects, reads the fields straight from the payload
+     * 
+     * No document is built and nothing is allocated. Payloads it can not read
+     * exactly like ArduinoJson, e.g. with escapes, quoted numbers or missing
+     * fields, are left to the document path.
+     * 
+     * @param payload 
+     * @param length 
+     * @param projection 
+     * @param into - see obtainMessage
+     * @return std::shared_ptr<Message> - nullptr to fall back to ArduinoJson
+     */
+    static std::shared_ptr<Message> translateFlatJson(const char* payload, size_t length, MessageFieldMask projection, const std::shared_ptr<Message>& into);
+
+    /**
+     * @brief Document path of decodeRecord, the document is only on the stack while it runs
+     * 
+     * @param payload 
+     * @param length 
+     * @param format - Json or MsgPack
+     * @param header 
+     * @param target 
+     * @param context 
+     * @param projection 
+     * @return DecodeStatus 
+     */
+    static DecodeStatus decodeRecordDocument(const char* payload, size_t length, WireFormat format, MessageHeader& header, RecordTarget target, void* context, MessageFieldMask projection);
+
+    /**
+     * @brief Document path of decodeInto, the document is only on the stack while it runs
+     * 
+     * @param payload 
+     * @param length 
+     * @param projection 
+     * @param into 
+     * @return DecodeStatus 
+     */
+    static DecodeStatus decodeIntoDocument(const char* payload, size_t length, MessageFieldMask projection, const std::shared_ptr<Message>& into);
+
+    /**
+     * @brief Deserialize a JSON or MessagePack payload, filtered to the fields of its type
+     * 
+     * @param payload 
+     * @param length 
+     * @param format 
+     * @param document 
+     * @param projection - specific fields to keep
+     * @return DeserializationError 
+     */
+    static DeserializationError deserializePayload(const char* payload, size_t length, WireFormat format, JsonDocument& document, MessageFieldMask projection);
+
+    /**
+     * @brief Read the frame and the fields of the message from a deserialized object
+     * 
+     * @param doc 
+     * @param projection - specific fields to read, the others keep their values
+     * @return true 
+     * @return false - a field has the wrong type or exceeds its capacity, msgId is set to zero
+     */
+    bool readJson(JsonObjectConst doc, MessageFieldMask projection = MESSAGE_FIELDS_ALL);
+
+    public:
+
+    unsigned int msgId = 0;                                     ///< id of the message
+    MessageType msgType = MessageType::DEFAULTMESSAGETYPE;      ///< type of the message
+    unsigned int msgLength = 0;                                 ///< length of the encoded message in bytes
+    Consignor msgConsignor = Consignor::DEFUALTCONSIGNOR;       ///< consignor of the message
+
+    /**
+     * @brief Document capacity needed to decode the message frame
+     * 
+     */
+    static constexpr size_t JSON_FRAME_CAPACITY = JSON_OBJECT_SIZE(4) +
+                                                  MESSAGE_JSON_NUMBER("msgId") +
+                                                  MESSAGE_JSON_NUMBER("msgType") +
+                                                  MESSAGE_JSON_NUMBER("msgLength") +
+                                                  MESSAGE_JSON_NUMBER("msgConsignor");
+
+    /**
+     * @brief Construct a new Message object
+     * 
+     */
+    Message();
+
+    /**
+     * @brief Destroy the Message object
+     * 
+     */
+    virtual ~Message();
+
     /**
      * @brief Static function to serialize a JSON object to a class
      * 
+     * The wire format is detected from the first byte: binary messages start
+     * with MESSAGE_BINARY_MAGIC, MessagePack messages with a map header and
+     * everything else is parsed as JSON.
+     * 
      * @param payload 
      * @param length 
+     * @param projection - specific fields to read, e.g. SOInitMessage::Fields::table().mask("line"),
+     *                     the others keep their defaults and are not stored in the document
      * 
      * @todo Change name to MessageFactory
      * 
      * @return std::shared_ptr<Message> 
      */
-    static std::shared_ptr<Message> translateJsonToStruct(const char* payload, unsigned int length); // MessageFactory
+    static std::shared_ptr<Message> translateJsonToStruct(const char* payload, unsigned int length, MessageFieldMask projection = MESSAGE_FIELDS_ALL); // MessageFactory
+
+    /**
+     * @brief Decode a payload in any wire format, JSON and MessagePack into the given document
+     * 
+     * Lets callers that decode many payloads reuse one document.
+     * 
+     * @param payload 
+     * @param length 
+     * @param document - parse arena, cleared by every call
+     * @param status - set to the outcome of the decode
+     * @param projection - specific fields to read, see translateJsonToStruct
+     * @return std::shared_ptr<Message> - nullptr if the type is unknown
+     */
+    static std::shared_ptr<Message> decode(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection = MESSAGE_FIELDS_ALL);
+
+    /**
+     * @brief Decode like decode, but parse JSON always with ArduinoJson
+     * 
+     * decode reads flat JSON objects without a document when MESSAGE_FLAT_JSON
+     * is set. This skips the fast path, e.g. to compare both in the benchmark.
+     * 
+     * @param payload 
+     * @param length 
+     * @param document 
+     * @param status 
+     * @param projection 
+     * @return std::shared_ptr<Message> 
+     */
+    static std::shared_ptr<Message> decodeDocument(const char* payload, size_t length, JsonDocument& document, DecodeStatus& status, MessageFieldMask projection = MESSAGE_FIELDS_ALL);
+
+    /**
+     * @brief Decode a payload in any wire format into an existing message
+     * 
+     * For control loops that keep one message per peer and overwrite it on
+     * every update. Nothing is allocated: the message is neither created nor
+     * taken from the pool, and JSON that misses the flat fast path is parsed
+     * into a stack document. The frame and the fields are overwritten like a
+     * new message from decode, so unprojected fields are reset to their
+     * defaults. On Malformed, NoMemory or Invalid msgId is set to zero, even
+     * if the type of the payload could not be read, and the fields may be
+     * partly overwritten.
+     * 
+     * @param message - message to overwrite, its msgType must match the payload
+     * @param payload 
+     * @param length 
+     * @param projection - specific fields to read, see translateJsonToStruct
+     * @return DecodeStatus - WrongType if the payload holds another type, the message is left unchanged
+     */
+    static DecodeStatus decodeInto(Message& message, const char* payload, size_t length, MessageFieldMask projection = MESSAGE_FIELDS_ALL);
+
+    /**
+     * @brief Read only the frame of a payload in any wire format
+     * 
+     * One pass over the bytes up to the last frame field, without a document
+     * and without creating a message. Lets routers drop irrelevant traffic
+     * before decoding it. Frame fields missing from the payload stay zero.
+     * 
+     * @param payload 
+     * @param length 
+     * @param header - set to msgId, msgType, msgLength and msgConsignor
+     * @return true - msgType was found, it may still be unregistered
+     * @return false - the payload is malformed before the end of the frame
+     */
+    static bool peekHeader(const char* payload, size_t length, MessageHeader& header);
+
+    /**
+     * @brief Decode a payload in any wire format into a frame and a fields struct
+     * 
+     * The building block of the value types in MessageValue.h: the frame is
+     * read once, then the fields go straight from the payload into the struct
+     * returned by target, without a message object. Takes the flat JSON path
+     * like decode; only payloads that miss it parse into a stack document.
+     * 
+     * @param payload 
+     * @param length 
+     * @param header - set to the frame, msgId is zero if the decode fails
+     * @param target - called once with the type of the payload
+     * @param context - passed to target
+     * @param projection - specific fields to read, the others keep the values set by target
+     * @return DecodeStatus - UnknownType if target returns nullptr
+     */
+    static DecodeStatus decodeRecord(const char* payload, size_t length, MessageHeader& header, RecordTarget target, void* context, MessageFieldMask projection = MESSAGE_FIELDS_ALL);
+
+    /**
+     * @brief Serialize a frame and a fields struct into a caller-supplied buffer
+     * 
+     * @param header - its msgType selects the field table
+     * @param fields - fields struct of the type
+     * @param buffer 
+     * @param size - size of the buffer including the terminating null
+     * @param format 
+     * @return size_t - length of the message, zero if the buffer is too small
+     */
+    static size_t serializeRecord(const MessageHeader& header, const void* fields, char* buffer, size_t size, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Serialize a frame and a fields struct into a Print
+     * 
+     * @param header - its msgType selects the field table
+     * @param fields - fields struct of the type
+     * @param output 
+     * @param format 
+     * @return size_t - number of bytes written
+     */
+    static size_t serializeRecord(const MessageHeader& header, const void* fields, Print& output, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Exact number of bytes serializeRecord will produce
+     * 
+     * @param header - its msgType selects the field table
+     * @param fields - fields struct of the type
+     * @param format 
+     * @return size_t 
+     */
+    static size_t measureRecord(const MessageHeader& header, const void* fields, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Outcome of a batch decode
+     * 
+     */
+    struct BatchResult
+    {
+        size_t items;                           ///< number of messages and statuses written
+        size_t failed;                          ///< number of items whose status is not DecodeStatus::Ok
+        bool complete;                          ///< false if the frame is malformed or has more items than capacity
+    };
+
+    /**
+     * @brief Decode a burst of payloads with one parse arena
+     * 
+     * Every payload may be in any wire format. The JSON document is created
+     * once per burst instead of once per message. Failed items are decoded
+     * like translateJsonToStruct does, nullptr for an unknown type and
+     * msgId zero otherwise.
+     * 
+     * @param payloads 
+     * @param count 
+     * @param messages - count entries, filled with the decoded messages
+     * @param status - count entries for the outcome of every item, may be nullptr
+     * @return BatchResult 
+     */
+    static BatchResult translateBatch(const MessagePayload* payloads, size_t count, std::shared_ptr<Message>* messages, DecodeStatus* status = nullptr);
+
+    /**
+     * @brief Decode a JSON array of messages with one parse arena
+     * 
+     * The elements are located in the frame without parsing and deserialized
+     * one after the other into the same document, so the frame may be larger
+     * than MESSAGE_JSON_CAPACITY. Decoding stops at the first element that is
+     * not an object or is unterminated.
+     * 
+     * @param frame - JSON array of message objects
+     * @param length 
+     * @param messages - capacity entries, filled with the decoded messages
+     * @param capacity 
+     * @param status - capacity entries for the outcome of every item, may be nullptr
+     * @return BatchResult 
+     */
+    static BatchResult translateJsonArray(const char* frame, size_t length, std::shared_ptr<Message>* messages, size_t capacity, DecodeStatus* status = nullptr);
+
+    /**
+     * @brief Split a frame of several messages back into its messages
+     * 
+     * Accepts the JSON arrays and the MESSAGE_BATCH_MAGIC frames written by
+     * serializeBatch. Any other payload is decoded as a single message.
+     * 
+     * @param frame 
+     * @param length 
+     * @param messages - capacity entries, filled with the decoded messages
+     * @param capacity 
+     * @param status - capacity entries for the outcome of every item, may be nullptr
+     * @return BatchResult 
+     */
+    static BatchResult translateFrame(const char* frame, size_t length, std::shared_ptr<Message>* messages, size_t capacity, DecodeStatus* status = nullptr);
+
+    /**
+     * @brief Serialize several messages into one frame in a caller-supplied buffer
+     * 
+     * JSON frames are an array of the messages. Binary and MsgPack frames are
+     * MESSAGE_BATCH_MAGIC, the number of messages and every message prefixed
+     * with its length. One frame needs one publish instead of one per message.
+     * 
+     * @param messages - count messages, none of them nullptr
+     * @param count 
+     * @param buffer 
+     * @param size - size of the buffer including the terminating null
+     * @param format 
+     * @return size_t - length of the frame, zero if the buffer is too small
+     */
+    static size_t serializeBatch(const std::shared_ptr<Message>* messages, size_t count, char* buffer, size_t size, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Serialize several messages into one frame in a Print
+     * 
+     * @param messages - count messages, none of them nullptr
+     * @param count 
+     * @param output 
+     * @param format 
+     * @return size_t - number of bytes written
+     */
+    static size_t serializeBatch(const std::shared_ptr<Message>* messages, size_t count, Print& output, WireFormat format = WireFormat::Json);
+
+    /**
+     * @brief Exact number of bytes serializeBatch will produce
+     * 
+     * @param messages - count messages, none of them nullptr
+     * @param count 
+     * @param format 
+     * @return size_t 
+     */
+    static size_t measureBatch(const std::shared_ptr<Message>* messages, size_t count, WireFormat format = WireFormat::Json);
+
+    private:
+
+    /**
+     * @brief Decode one item of a batch into the next entry of the output
+     * 
+     * @param item 
+     * @param document - parse arena shared by the batch
+     * @param messages 
+     * @param status - may be nullptr
+     * @param result - items and failed are counted up
+     */
+    static void decodeItem(const MessagePayload& item, JsonDocument& document, std::shared_ptr<Message>* messages, DecodeStatus* status, BatchResult& result);
+
+    /**
+     * @brief Write several messages as one frame
+     * 
+     * @param writer 
+     * @param messages 
+     * @param count 
+     * @param record - add the messages to MessageMetrics, false for a dry run
+     */
+    static void writeBatch(MessageWriter& writer, const std::shared_ptr<Message>* messages, size_t count, bool record);
+
+    public:
 
     /**
      * @brief Static function to serialize a message class to a publish string
@@ -110,36 +558,140 @@ class Message
     static String translateStructToString(std::shared_ptr<Message> object); // raus nehmen
     
     /**
-     * @brief Virtual function to parse JSON object to a message class
+     * @brief Parse JSON object to a message class
      * 
-     * @param doc 
+     * The object is a read-only view into the document of the caller, so
+     * parsing neither copies the document nor allocates.
+     * 
+     * @param doc - read-only view of the deserialized root object
      * @param error 
      */
-    virtual void parseJSONToStruct(JsonDocument doc, DeserializationError error) = 0;   
+    virtual void parseJSONToStruct(JsonObjectConst doc, DeserializationError error);
+
+    /**
+     * @brief Virtual function to read the specific fields of a message class
+     * 
+     * @param reader 
+     */
+    virtual void readFields(MessageReader& reader) = 0;
+
+    /**
+     * @brief Serialize the message into a caller-supplied buffer without heap use
+     * 
+     * @param buffer 
+     * @param size - size of the buffer including the terminating null
+     * @param format 
+     * @return size_t - length of the message, zero if the buffer is too small
+     */
+    size_t serialize(char* buffer, size_t size, WireFormat format = WireFormat::Json) const;
 
     /**
-     * @brief Virtual function to parse a message class to a publish string
+     * @brief Serialize the message into a Print without heap use
+     * 
+     * @param output 
+     * @param format 
+     * @return size_t - number of bytes written
+     */
+    size_t serialize(Print& output, WireFormat format = WireFormat::Json) const;
+
+    /**
+     * @brief Exact number of bytes serialize will produce, without the terminating null
+     * 
+     * @param format 
+     * @return size_t 
+     */
+    size_t measure(WireFormat format = WireFormat::Json) const;
+
+    /**
+     * @brief Set msgLength to the length of the JSON encoding of the message
+     * 
+     * Called by every setMessage. Call it again after changing fields directly.
+     * 
+     */
+    void updateLength();
+
+    /**
+     * @brief Virtual function to write the specific fields of a message class
+     * 
+     * @param writer 
+     */
+    virtual void writeFields(MessageWriter& writer) const = 0;
+
+    /**
+     * @brief Parse the message class to a publish string
+     * 
+     * Kept for existing callers, allocates the string once.
      * 
      * @return String 
      */
-    virtual String parseStructToString() = 0;
+    virtual String parseStructToString();
 };
 
+/**
+ * @brief Frame of every message, filled by Message::peekHeader and the value types
+ *
+ */
+struct MessageHeader
+{
+    unsigned int msgId = 0;                                                     ///< id of the message
+    Message::MessageType msgType = Message::MessageType::DEFAULTMESSAGETYPE;    ///< type of the message
+    unsigned int msgLength = 0;                                                 ///< length of the JSON encoding in bytes
+    Consignor msgConsignor = Consignor::DEFUALTCONSIGNOR;                       ///< consignor of the message
+};
 
 
+/**
+ * @brief Fields of the package message
+ * 
+ */
+struct PackageFields
+{
+    unsigned int packageId = 0;                             ///< id of the package
+    MessageSymbol cargo = "-1";                             ///< cargo of the package
+    FixedString<MESSAGE_REGION_LENGTH> targetDest = "-1";   ///< target destination of the package
+    MessageSymbol targetReg = "-1";                         ///< target region of the package
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<PackageFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(PackageFields, packageId),
+            MESSAGE_FIELD(PackageFields, cargo),
+            MESSAGE_FIELD(PackageFields, targetDest),
+            MESSAGE_FIELD(PackageFields, targetReg),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize package message
  * 
  */
-class PackageMessage : public Message
+class PackageMessage : public Message, public PackageFields
 {
 private:
 public:
 
-    unsigned int packageId = 0;                 ///< id of the package
-    String cargo = "-1";                        ///< cargo of the package
-    String targetDest = "-1";                   ///< target destination of the package
-    String targetReg = "-1";                    ///< target region of the package
+    static constexpr MessageType TYPE = MessageType::Package;    ///< type of the message class
+    typedef PackageFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(4) +
+                                            MESSAGE_JSON_NUMBER("packageId") +
+                                            MESSAGE_JSON_MEMBER("cargo", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("targetDest", MESSAGE_REGION_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("targetReg", MESSAGE_SYMBOL_LENGTH);
 
     /**
      * @brief Construct a new Parse Package Message object
@@ -154,19 +706,18 @@ public:
     ~PackageMessage();
 
     /**
-     * @brief Parse JSON object to the PackageMessage class
+     * @brief Read the fields of the PackageMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the PackageMessage class to a publish string
+     * @brief Write the fields of the PackageMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the PackageMessage object
@@ -181,18 +732,53 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, unsigned int messagePackageId, String messageCargo, String messageTargetDest, String messageTargetReg);
 };
 
+/**
+ * @brief Fields of the error message
+ * 
+ */
+struct ErrorFields
+{
+    bool error = false;                                     ///< error
+    bool token = false;                                     ///< token
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<ErrorFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(ErrorFields, error),
+            MESSAGE_FIELD(ErrorFields, token),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize error message
  * 
  */
-class ErrorMessage : public Message
+class ErrorMessage : public Message, public ErrorFields
 {
 
 private:
 public:
 
-    bool error;                     ///< error
-    bool token;                     ///< token
+    static constexpr MessageType TYPE = MessageType::Error;    ///< type of the message class
+    typedef ErrorFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(2) +
+                                            MESSAGE_JSON_NUMBER("error") +
+                                            MESSAGE_JSON_NUMBER("token");
 
     /**
      * @brief Construct a new Parse Error Message object
@@ -207,20 +793,18 @@ public:
     ~ErrorMessage();
 
     /**
-     * @brief Parse JSON object to the ErrorMessage class
+     * @brief Read the fields of the ErrorMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the ErrorMessage class to a publish string
+     * @brief Write the fields of the ErrorMessage class
      * 
-     * @param messageClass - ErrorMessage
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the ErrorMessage object
@@ -233,18 +817,55 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, bool messageError, bool messageToken);
 };
 
+/**
+ * @brief Fields of the smartbox available message
+ * 
+ */
+struct SBAvailableFields
+{
+    MessageSymbol sector = "-1";                            ///< sector of the smart box
+    int line = -1;                                          ///< line of the smart box
+    MessageSymbol targetReg = "-1";                         ///< target region of the smart box
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SBAvailableFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SBAvailableFields, sector),
+            MESSAGE_FIELD(SBAvailableFields, line),
+            MESSAGE_FIELD(SBAvailableFields, targetReg),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartbox available message
  * 
  */
-class SBAvailableMessage : public Message
+class SBAvailableMessage : public Message, public SBAvailableFields
 {
 private:
 public:
 
-    String sector = "-1";                           ///< sector of the smart box
-    int line = -1;                                  ///< line of the smart box
-    String targetReg = "-1";                        ///< target region of the smart box
+    static constexpr MessageType TYPE = MessageType::SBAvailable;    ///< type of the message class
+    typedef SBAvailableFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(3) +
+                                            MESSAGE_JSON_MEMBER("sector", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line") +
+                                            MESSAGE_JSON_MEMBER("targetReg", MESSAGE_SYMBOL_LENGTH);
 
     /**
      * @brief Construct a new Parse SB Available Message object
@@ -259,20 +880,18 @@ public:
     ~SBAvailableMessage();
     
     /**
-     * @brief Parse JSON object to the SBAvailableMessage class
+     * @brief Read the fields of the SBAvailableMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SBAvailableMessage class to a publish string
+     * @brief Write the fields of the SBAvailableMessage class
      * 
-     * @param messageClass - SBAvailableMessage
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SBAvailableMessage object
@@ -287,17 +906,52 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine, String messageTargetReg);
 };
 
+/**
+ * @brief Fields of the smartbox position message
+ * 
+ */
+struct SBPositionFields
+{
+    MessageSymbol sector = "-1";                            ///< sector of the smart box
+    int line = -1;                                          ///< line of the smart box
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SBPositionFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SBPositionFields, sector),
+            MESSAGE_FIELD(SBPositionFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartbox position message
  * 
  */
-class SBPositionMessage : public Message
+class SBPositionMessage : public Message, public SBPositionFields
 {
 private:
 public:
 
-    String sector = "-1";                           ///< sector of the smart box
-    int line = -1;                                  ///< line of the smart box
+    static constexpr MessageType TYPE = MessageType::SBPosition;    ///< type of the message class
+    typedef SBPositionFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(2) +
+                                            MESSAGE_JSON_MEMBER("sector", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse S B Position Message object
@@ -312,19 +966,18 @@ public:
     ~SBPositionMessage();
 
     /**
-     * @brief Parse JSON object to the SBPositionMessage class
+     * @brief Read the fields of the SBPositionMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SBPositionMessage class to a publish string
+     * @brief Write the fields of the SBPositionMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SBPositionMessage object
@@ -337,16 +990,49 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine);
 };
 
+/**
+ * @brief Fields of the smartbox state message
+ * 
+ */
+struct SBStateFields
+{
+    MessageSymbol state = "-1";                             ///< state of the smart box
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SBStateFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SBStateFields, state),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartbox state message
  * 
  */
-class SBStateMessage : public Message
+class SBStateMessage : public Message, public SBStateFields
 {
 private:
 public:
 
-    String state = "-1";                            ///< state of the smart box
+    static constexpr MessageType TYPE = MessageType::SBState;    ///< type of the message class
+    typedef SBStateFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(1) +
+                                            MESSAGE_JSON_MEMBER("state", MESSAGE_SYMBOL_LENGTH);
 
     /**
      * @brief Construct a new Parse S B State Message object
@@ -361,20 +1047,18 @@ public:
     ~SBStateMessage();
 
     /**
-     * @brief Parse JSON object to the SBStateMessage class
+     * @brief Read the fields of the SBStateMessage class
      * 
-     * @param doc - JsonDocument
-     * @param error - DeserializationError
-     * @return SBStateMessage*
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SBStateMessage class to a publish string
+     * @brief Write the fields of the SBStateMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SBStateMessage object
@@ -386,20 +1070,60 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageState);
 };
 
+/**
+ * @brief Fields of the smartbox to smartvehicle handshake message
+ * 
+ */
+struct SBToSVHandshakeFields
+{
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> reck = "-1";      ///< request ID
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> ack = "-1";       ///< acknoledge ID
+    MessageSymbol cargo = "-1";                             ///< cargo
+    int line = -1;                                          ///< line
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SBToSVHandshakeFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SBToSVHandshakeFields, reck),
+            MESSAGE_FIELD(SBToSVHandshakeFields, ack),
+            MESSAGE_FIELD(SBToSVHandshakeFields, cargo),
+            MESSAGE_FIELD(SBToSVHandshakeFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartbox to smartvehicle handshake message
  * 
  */
-class SBToSVHandshakeMessage : public Message
+class SBToSVHandshakeMessage : public Message, public SBToSVHandshakeFields
 {
 private:   
 public:
 
-    String reck = "-1";                                     ///< request ID
-    String ack = "-1";                                      ///< acknoledge ID
-    String cargo = "-1";                                    ///< cargo
-    String targetReg = "-1";                                ///< target region
-    int line = -1;                                          ///< line
+    MessageSymbol targetReg = "-1";                         ///< target region
+
+    static constexpr MessageType TYPE = MessageType::SBToSVHandshake;    ///< type of the message class
+    typedef SBToSVHandshakeFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(4) +
+                                            MESSAGE_JSON_MEMBER("reck", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("ack", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("cargo", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse SB to SV Handshake Message object
@@ -414,19 +1138,18 @@ public:
     ~SBToSVHandshakeMessage();
 
     /**
-     * @brief Parse JSON object to the SBToSVHandshakeMessage class
+     * @brief Read the fields of the SBToSVHandshakeMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SBToSVHandshakeMessage class to a publish string
+     * @brief Write the fields of the SBToSVHandshakeMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SBToSVHandshakeMessage object
@@ -442,17 +1165,52 @@ public:
 };
 
 
+/**
+ * @brief Fields of the smartvehicle available message
+ * 
+ */
+struct SVAvailableFields
+{
+    MessageSymbol sector = "-1";                            ///< sector of the smart vehicle
+    int line = -1;                                          ///< line of the smart vehicle
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SVAvailableFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SVAvailableFields, sector),
+            MESSAGE_FIELD(SVAvailableFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartvehicle available message
  * 
  */
-class SVAvailableMessage : public Message
+class SVAvailableMessage : public Message, public SVAvailableFields
 {
 private:
 public:
 
-    String sector = "-1";                               ///< sector of the smart vehicle
-    int line = -1;                                      ///< line of the smart vehicle
+    static constexpr MessageType TYPE = MessageType::SVAvailable;    ///< type of the message class
+    typedef SVAvailableFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(2) +
+                                            MESSAGE_JSON_MEMBER("sector", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse SV Available Message object
@@ -467,19 +1225,18 @@ public:
     ~SVAvailableMessage();
 
     /**
-     * @brief Parse JSON object to the SVAvailableMessage class
+     * @brief Read the fields of the SVAvailableMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SVAvailableMessage class to a publish string
+     * @brief Write the fields of the SVAvailableMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SVAvailableMessage object
@@ -492,17 +1249,52 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine);
 };
 
+/**
+ * @brief Fields of the smartvehicle position message
+ * 
+ */
+struct SVPositionFields
+{
+    MessageSymbol sector = "-1";                            ///< sector of the smart vehicle
+    int line = -1;                                          ///< line of the smart vehicle
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SVPositionFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SVPositionFields, sector),
+            MESSAGE_FIELD(SVPositionFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartvehicle position message
  * 
  */
-class SVPositionMessage : public Message
+class SVPositionMessage : public Message, public SVPositionFields
 {
 private:
 public:
 
-    String sector = "-1";                               ///< sector of the smart vehicle
-    int line = -1;                                      ///< line of the smart vehicle
+    static constexpr MessageType TYPE = MessageType::SVPosition;    ///< type of the message class
+    typedef SVPositionFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(2) +
+                                            MESSAGE_JSON_MEMBER("sector", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse SV Position Message object
@@ -517,19 +1309,18 @@ public:
     ~SVPositionMessage();
 
     /**
-     * @brief Parse JSON object to the SVPositionMessage class
+     * @brief Read the fields of the SVPositionMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SVPositionMessage class to a publish string
+     * @brief Write the fields of the SVPositionMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SVPositionMessage object
@@ -542,16 +1333,49 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageSector, int messageLine);
 };
 
+/**
+ * @brief Fields of the smartvehicle state message
+ * 
+ */
+struct SVStateFields
+{
+    MessageSymbol state = "-1";                             ///< state of the smart vehicle
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SVStateFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SVStateFields, state),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartvehicle state message
  * 
  */
-class SVStateMessage : public Message
+class SVStateMessage : public Message, public SVStateFields
 {
 private:
 public:
 
-    String state = "-1";                    ///< state of the smart vehicle
+    static constexpr MessageType TYPE = MessageType::SVState;    ///< type of the message class
+    typedef SVStateFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(1) +
+                                            MESSAGE_JSON_MEMBER("state", MESSAGE_SYMBOL_LENGTH);
 
     /**
      * @brief Construct a new Parse SV State Message object
@@ -566,19 +1390,18 @@ public:
     ~SVStateMessage();
 
     /**
-     * @brief Parse JSON object to the SVStateMessage class
+     * @brief Read the fields of the SVStateMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SVStateMessage class to a publish string
+     * @brief Write the fields of the SVStateMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SVStateMessage object
@@ -590,20 +1413,61 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageState);
 };
 
+/**
+ * @brief Fields of the smartbox to sortic handshake message
+ * 
+ */
+struct SBToSOHandshakeFields
+{
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> req = "-1";       ///< request
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> ack = "-1";       ///< acknoledge
+    MessageSymbol cargo = "-1";                             ///< cargo
+    MessageSymbol targetReg = "-1";                         ///< target region
+    int line = -1;                                          ///< line
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SBToSOHandshakeFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SBToSOHandshakeFields, req),
+            MESSAGE_FIELD(SBToSOHandshakeFields, ack),
+            MESSAGE_FIELD(SBToSOHandshakeFields, cargo),
+            MESSAGE_FIELD(SBToSOHandshakeFields, targetReg),
+            MESSAGE_FIELD(SBToSOHandshakeFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize smartbox to sortic handshake message
  * 
  */
-class SBToSOHandshakeMessage : public Message
+class SBToSOHandshakeMessage : public Message, public SBToSOHandshakeFields
 {
 private:
 public:
 
-    String req = "-1";                                      ///< request
-    String ack = "-1";                                      ///< acknoledge
-    String cargo = "-1";                                    ///< cargo
-    String targetReg = "-1";                                ///< target region
-    int line = -1;                                          ///< line
+    static constexpr MessageType TYPE = MessageType::SBToSOHandshake;    ///< type of the message class
+    typedef SBToSOHandshakeFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(5) +
+                                            MESSAGE_JSON_MEMBER("req", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("ack", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("cargo", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("targetReg", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse SB to SO Handshake Message object
@@ -618,19 +1482,18 @@ public:
     ~SBToSOHandshakeMessage();
 
     /**
-     * @brief Parse JSON object to the SBToSOHandshakeMessage class
+     * @brief Read the fields of the SBToSOHandshakeMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the SBToSOHandshakeMessage class to a publish string
+     * @brief Write the fields of the SBToSOHandshakeMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SBToSOHandshakeMessage object
@@ -646,16 +1509,49 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageReck, String messageAck = "-1", String messageCargo = "-1", String messageTargetReg = "-1", int messageLine = -1);
 };
 
+/**
+ * @brief Fields of the sortic position message
+ * 
+ */
+struct SOPositionFields
+{
+    int line = -1;                                          ///< line of the sortic roboter
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SOPositionFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SOPositionFields, line),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize sortic position message
  * 
  */
-class SOPositionMessage : public Message
+class SOPositionMessage : public Message, public SOPositionFields
 {
 private:
 public:
 
-    int line = -1;                              ///< line of the sortic roboter
+    static constexpr MessageType TYPE = MessageType::SOPosition;    ///< type of the message class
+    typedef SOPositionFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(1) +
+                                            MESSAGE_JSON_NUMBER("line");
 
     /**
      * @brief Construct a new Parse SO Position Message object
@@ -670,19 +1566,18 @@ public:
     ~SOPositionMessage();
 
     /**
-     * @brief Parse JSON object to the SOPositionMessage class
+     * @brief Read the fields of the SOPositionMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
 
     /**
-     * @brief Parse the SOPositionMessage class to a publish string
+     * @brief Write the fields of the SOPositionMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SOPositionMessage object
@@ -694,16 +1589,49 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, int messageLine);
 };
 
+/**
+ * @brief Fields of the sortic state message
+ * 
+ */
+struct SOStateFields
+{
+    MessageSymbol state;                                    ///< state of the sortic roboter
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SOStateFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SOStateFields, state),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize sortic state message
  * 
  */
-class SOStateMessage : public Message
+class SOStateMessage : public Message, public SOStateFields
 {
 private:
 public:
 
-    String state;                   ///< state of the sortic roboter
+    static constexpr MessageType TYPE = MessageType::SOState;    ///< type of the message class
+    typedef SOStateFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(1) +
+                                            MESSAGE_JSON_MEMBER("state", MESSAGE_SYMBOL_LENGTH);
 
     /**
      * @brief Construct a new Parse SO State Message object
@@ -718,19 +1646,18 @@ public:
     ~SOStateMessage();
 
     /**
-     * @brief Parse JSON object to the SOStateMessage class
+     * @brief Read the fields of the SOStateMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
 
     /**
-     * @brief Parse the SOStateMessage class to a publish string
+     * @brief Write the fields of the SOStateMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SOStateMessage object
@@ -742,25 +1669,76 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, String messageState);
 };
 
+/**
+ * @brief Fields of the sortic state message
+ * 
+ */
+struct SOInitFields
+{
+    MessageSymbol state;                                    ///< state
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> req = "-1";       ///< request
+    FixedString<MESSAGE_HANDSHAKE_LENGTH> ack = "-1";       ///< acknoledge
+    MessageSymbol cargo = "-1";                             ///< cargo
+    MessageSymbol targetReg = "-1";                         ///< target region
+    int line = -1;                                          ///< line
+    unsigned int packageId = 0;                             ///< package id
+    FixedString<MESSAGE_REGION_LENGTH> targetDest = "-1";   ///< target destination
+    bool error = false;                                     ///< error
+    bool token = false;                                     ///< token
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<SOInitFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(SOInitFields, state),
+            MESSAGE_FIELD(SOInitFields, req),
+            MESSAGE_FIELD(SOInitFields, ack),
+            MESSAGE_FIELD(SOInitFields, cargo),
+            MESSAGE_FIELD(SOInitFields, targetReg),
+            MESSAGE_FIELD(SOInitFields, line),
+            MESSAGE_FIELD(SOInitFields, packageId),
+            MESSAGE_FIELD(SOInitFields, targetDest),
+            MESSAGE_FIELD(SOInitFields, error),
+            MESSAGE_FIELD(SOInitFields, token),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize sortic state message
  * 
  */
-class SOInitMessage : public Message
+class SOInitMessage : public Message, public SOInitFields
 {
 private:
 public:
 
-    String state;                           ///< state
-    String req = "-1";                      ///< request
-    String ack = "-1";                      ///< acknoledge
-    String cargo = "-1";                    ///< cargo
-    String targetReg = "-1";                ///< target region
-    int line = -1;                          ///< line
-    unsigned int packageId = 0;             ///< package id
-    String targetDest = "-1";               ///< target destination
-    bool error;                             ///< error
-    bool token;                             ///< token
+    static constexpr MessageType TYPE = MessageType::SOInit;    ///< type of the message class
+    typedef SOInitFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(10) +
+                                            MESSAGE_JSON_MEMBER("state", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("req", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("ack", MESSAGE_HANDSHAKE_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("cargo", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_MEMBER("targetReg", MESSAGE_SYMBOL_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("line") +
+                                            MESSAGE_JSON_NUMBER("packageId") +
+                                            MESSAGE_JSON_MEMBER("targetDest", MESSAGE_REGION_LENGTH) +
+                                            MESSAGE_JSON_NUMBER("error") +
+                                            MESSAGE_JSON_NUMBER("token");
 
     /**
      * @brief Construct a new Parse SO Init Message object
@@ -775,19 +1753,18 @@ public:
     ~SOInitMessage();
 
     /**
-     * @brief Parse JSON object to the SOStateMessage class
+     * @brief Read the fields of the SOInitMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
 
     /**
-     * @brief Parse the SOStateMessage class to a publish string
+     * @brief Write the fields of the SOStateMessage class
      * 
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the SOStateMessage object
@@ -799,18 +1776,53 @@ public:
     void setMessage();
 };
 
+/**
+ * @brief Fields of the error message
+ * 
+ */
+struct BufferFields
+{
+    bool full = false;                                      ///< full parameter
+    bool cleared = false;                                   ///< cleared parameter
+
+    /**
+     * @brief Field descriptors in wire order
+     * 
+     * @return MessageFieldTable 
+     */
+    static MessageFieldTable table()
+    {
+        static_assert(std::is_standard_layout<BufferFields>::value, "field offsets need a standard-layout struct");
+        static constexpr MessageField FIELDS[] = {
+            MESSAGE_FIELD(BufferFields, full),
+            MESSAGE_FIELD(BufferFields, cleared),
+        };
+        static constexpr MessageFieldIndex INDEX = messageFieldIndex(FIELDS);
+        return MessageFieldTable(FIELDS, &INDEX);
+    }
+};
+
 /**
  * @brief Child class to serialize error message
  * 
  */
-class BufferMessage : public Message
+class BufferMessage : public Message, public BufferFields
 {
 
 private:
 public:
 
-    bool full;                      ///< full parameter
-    bool cleared;                   ///< cleared parameter
+    static constexpr MessageType TYPE = MessageType::SOBuffer;    ///< type of the message class
+    typedef BufferFields Fields;    ///< fields of the message class
+
+    /**
+     * @brief Document capacity needed to decode the message
+     * 
+     */
+    static constexpr size_t JSON_CAPACITY = Message::JSON_FRAME_CAPACITY +
+                                            JSON_OBJECT_SIZE(2) +
+                                            MESSAGE_JSON_NUMBER("full") +
+                                            MESSAGE_JSON_NUMBER("cleared");
 
     /**
      * @brief Construct a new Parse Error Message object
@@ -825,20 +1837,18 @@ public:
     ~BufferMessage();
 
     /**
-     * @brief Parse JSON object to the BufferMessage class
+     * @brief Read the fields of the BufferMessage class
      * 
-     * @param doc 
-     * @param error 
+     * @param reader 
      */
-    void parseJSONToStruct(JsonDocument doc, DeserializationError error) override;
+    void readFields(MessageReader& reader) override;
     
     /**
-     * @brief Parse the BufferMessage class to a publish string
+     * @brief Write the fields of the BufferMessage class
      * 
-     * @param messageClass - BufferMessage
-     * @return String 
+     * @param writer 
      */
-    String parseStructToString() override;
+    void writeFields(MessageWriter& writer) const override;
 
     /**
      * @brief Set the BufferMessage object
@@ -851,4 +1861,43 @@ public:
     void setMessage(unsigned int messageId, Consignor messageConsignor, bool messageFull, bool messageCleared);
 };
 
+/**
+ * @brief Largest of the given capacities
+ * 
+ * @param capacity 
+ * @return constexpr size_t 
+ */
+constexpr size_t messageMaxCapacity(size_t capacity)
+{
+    return capacity;
+}
+
+template<typename... Capacities>
+constexpr size_t messageMaxCapacity(size_t first, Capacities... rest)
+{
+    return first > messageMaxCapacity(rest...) ? first : messageMaxCapacity(rest...);
+}
+
+/**
+ * @brief Capacity of the document used to decode any message type
+ * 
+ * Computed at compile time from the field lists of all message classes, so
+ * translateJsonToStruct can decode into a stack document without heap use.
+ * 
+ */
+constexpr size_t MESSAGE_JSON_CAPACITY = messageMaxCapacity(PackageMessage::JSON_CAPACITY,
+                                                            ErrorMessage::JSON_CAPACITY,
+                                                            SBAvailableMessage::JSON_CAPACITY,
+                                                            SBPositionMessage::JSON_CAPACITY,
+                                                            SBStateMessage::JSON_CAPACITY,
+                                                            SBToSVHandshakeMessage::JSON_CAPACITY,
+                                                            SVAvailableMessage::JSON_CAPACITY,
+                                                            SVPositionMessage::JSON_CAPACITY,
+                                                            SVStateMessage::JSON_CAPACITY,
+                                                            SBToSOHandshakeMessage::JSON_CAPACITY,
+                                                            SOPositionMessage::JSON_CAPACITY,
+                                                            SOStateMessage::JSON_CAPACITY,
+                                                            SOInitMessage::JSON_CAPACITY,
+                                                            BufferMessage::JSON_CAPACITY);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,438 @@
+/**
+ * @file main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Host benchmark for decoding and encoding all message types
+ * @version 0.1
+ * @date 2020-03-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * Runs every message type through Message::translateJsonToStruct, which
+ * reads flat JSON without ArduinoJson, and through Message::decodeDocument
+ * (decdom), which always builds the document, into a long-lived message
+ * with Message::decodeInto (decinto),
+ * parseStructToString and serialize into a buffer (encbuf), in JSON and in
+ * the binary format (encbin, decbin), in MessagePack (encmsgpack,
+ * decmsgpack), through the value types (encvalue, decvalue) and reads only
+ * the frame of the JSON payload with Message::peekHeader (peek). decproj
+ * decodes only the first specific field of the JSON payload. It reports
+ * ns/op, allocations/op and bytes/op. The Burst rows decode one message of
+ * every type per operation, one by one (decode), with translateBatch
+ * (decbatch) and from one JSON array frame (decarray), and encode them into
+ * one frame with serializeBatch (encbatch, encbinbatch, decbinframe). decstream
+ * feeds the JSON array frame in 64 byte chunks to a MessageStreamDecoder.
+ * dec-* and arr-* repeat decode and decarray with each structural scan
+ * backend the CPU supports (scalar, sse2, avx2).
+ * Allocations are counted by wrapping the glibc allocator, so heap use of
+ * ArduinoJson (malloc) and of the STL (operator new) are both included.
+ *
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "MessageStream.h"
+#include "MessageStructural.h"
+#include "MessageValue.h"
+#include "Messages.h"
+
+//======================ALLOCATIONCOUNTER================================================
+//=======================================================================================
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+static size_t allocationCount = 0;              ///< number of allocations since start
+static size_t allocationBytes = 0;              ///< number of requested bytes since start
+
+extern "C" void* malloc(size_t size)
+{
+    ++allocationCount;
+    allocationBytes += size;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    ++allocationCount;
+    allocationBytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+    ++allocationCount;
+    allocationBytes += size;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer)
+{
+    __libc_free(pointer);
+}
+
+//======================SAMPLES==========================================================
+//=======================================================================================
+
+/**
+ * @brief Sample message of one message type
+ *
+ */
+struct Sample
+{
+    const char* name;                                           ///< name of the message class
+    std::function<std::shared_ptr<Message>()> create;           ///< creates a filled message
+};
+
+static const Sample samples[] = {
+    {"PackageMessage", [] {
+        auto msg = std::make_shared<PackageMessage>();
+        msg->setMessage(1201, Consignor::SO1, 42, "screws", "SB2", "sector3");
+        return std::shared_ptr<Message>(msg); }},
+    {"ErrorMessage", [] {
+        auto msg = std::make_shared<ErrorMessage>();
+        msg->setMessage(1202, Consignor::SB1, true, false);
+        return std::shared_ptr<Message>(msg); }},
+    {"SBAvailableMessage", [] {
+        auto msg = std::make_shared<SBAvailableMessage>();
+        msg->setMessage(1203, Consignor::SB1, "sector2", 3, "sector3");
+        return std::shared_ptr<Message>(msg); }},
+    {"SBPositionMessage", [] {
+        auto msg = std::make_shared<SBPositionMessage>();
+        msg->setMessage(1204, Consignor::SB2, "sector2", 4);
+        return std::shared_ptr<Message>(msg); }},
+    {"SBStateMessage", [] {
+        auto msg = std::make_shared<SBStateMessage>();
+        msg->setMessage(1205, Consignor::SB3, "loading");
+        return std::shared_ptr<Message>(msg); }},
+    {"SBToSVHandshakeMessage", [] {
+        auto msg = std::make_shared<SBToSVHandshakeMessage>();
+        msg->setMessage(1206, Consignor::SB1, "SB1", "SV2", "screws", 2);
+        return std::shared_ptr<Message>(msg); }},
+    {"SVAvailableMessage", [] {
+        auto msg = std::make_shared<SVAvailableMessage>();
+        msg->setMessage(1207, Consignor::SV1, "sector1", 1);
+        return std::shared_ptr<Message>(msg); }},
+    {"SVPositionMessage", [] {
+        auto msg = std::make_shared<SVPositionMessage>();
+        msg->setMessage(1208, Consignor::SV2, "sector1", 2);
+        return std::shared_ptr<Message>(msg); }},
+    {"SVStateMessage", [] {
+        auto msg = std::make_shared<SVStateMessage>();
+        msg->setMessage(1209, Consignor::SV3, "driving");
+        return std::shared_ptr<Message>(msg); }},
+    {"SBToSOHandshakeMessage", [] {
+        auto msg = std::make_shared<SBToSOHandshakeMessage>();
+        msg->setMessage(1210, Consignor::SB2, "SB2", "SO1", "screws", "sector3", 4);
+        return std::shared_ptr<Message>(msg); }},
+    {"SOPositionMessage", [] {
+        auto msg = std::make_shared<SOPositionMessage>();
+        msg->setMessage(1211, Consignor::SO1, 5);
+        return std::shared_ptr<Message>(msg); }},
+    {"SOStateMessage", [] {
+        auto msg = std::make_shared<SOStateMessage>();
+        msg->setMessage(1212, Consignor::SO1, "sorting");
+        return std::shared_ptr<Message>(msg); }},
+    {"SOInitMessage", [] {
+        auto msg = std::make_shared<SOInitMessage>();
+        msg->setMessage();
+        msg->msgId = 1213;
+        return std::shared_ptr<Message>(msg); }},
+    {"BufferMessage", [] {
+        auto msg = std::make_shared<BufferMessage>();
+        msg->setMessage(1214, Consignor::SO1, false, true);
+        return std::shared_ptr<Message>(msg); }},
+};
+
+//======================MEASUREMENT======================================================
+//=======================================================================================
+
+/**
+ * @brief Result of one measured operation
+ *
+ */
+struct Result
+{
+    double nsPerOp;                             ///< wall time per operation
+    double allocsPerOp;                         ///< heap allocations per operation
+    double bytesPerOp;                          ///< requested heap bytes per operation
+    unsigned long failed;                       ///< number of failed operations
+};
+
+static bool csvOutput = false;                  ///< print csv instead of a table
+
+/**
+ * @brief Run an operation iterations times and measure it
+ *
+ * @param iterations
+ * @param operation - returns false if the operation failed
+ * @return Result
+ */
+static Result measure(unsigned long iterations, const std::function<bool()>& operation)
+{
+    // warm up caches and lazily initialised state
+    for (unsigned long i = 0; i < iterations / 10 + 1; i++)
+    {
+        operation();
+    }
+
+    Result result = {0, 0, 0, 0};
+    size_t startCount = allocationCount;
+    size_t startBytes = allocationBytes;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        if (!operation())
+        {
+            result.failed++;
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    result.nsPerOp = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / iterations;
+    result.allocsPerOp = (double)(allocationCount - startCount) / iterations;
+    result.bytesPerOp = (double)(allocationBytes - startBytes) / iterations;
+    return result;
+}
+
+/**
+ * @brief Print one result line
+ *
+ * @param name
+ * @param operation
+ * @param result
+ */
+static void report(const char* name, const char* operation, const Result& result)
+{
+    const char* format = csvOutput ? "%s,%s,%.1f,%.2f,%.1f,%lu\n" : "%-24s %-11s %10.1f %10.2f %10.1f %8lu\n";
+    std::printf(format, name, operation, result.nsPerOp, result.allocsPerOp, result.bytesPerOp, result.failed);
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long iterations = 100000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csvOutput = true;
+        }
+        else
+        {
+            iterations = std::strtoul(argv[i], nullptr, 10);
+        }
+    }
+    if (iterations == 0)
+    {
+        iterations = 1;
+    }
+
+    std::printf(csvOutput ? "message,op,ns/op,allocs/op,bytes/op,failed\n" : "%-24s %-11s %10s %10s %10s %8s\n", "message", "op", "ns/op", "allocs/op", "bytes/op", "failed");
+
+    for (const Sample& sample : samples)
+    {
+        std::shared_ptr<Message> message = sample.create();
+        String payload = message->parseStructToString();
+
+        Result encode = measure(iterations, [&] {
+            String encoded = message->parseStructToString();
+            return encoded.length() > 0;
+        });
+        report(sample.name, "encode", encode);
+
+        char buffer[512];
+        Result encodeBuffer = measure(iterations, [&] {
+            return message->serialize(buffer, sizeof(buffer)) > 0;
+        });
+        report(sample.name, "encbuf", encodeBuffer);
+
+        Result decode = measure(iterations, [&] {
+            std::shared_ptr<Message> decoded = Message::translateJsonToStruct(payload.c_str(), payload.length());
+            return decoded && decoded->msgId != 0;
+        });
+        report(sample.name, "decode", decode);
+
+        StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+        Result decodeDocument = measure(iterations, [&] {
+            DecodeStatus status;
+            std::shared_ptr<Message> decoded = Message::decodeDocument(payload.c_str(), payload.length(), document, status);
+            return decoded && status == DecodeStatus::Ok;
+        });
+        report(sample.name, "decdom", decodeDocument);
+
+        std::shared_ptr<Message> target = sample.create();
+        Result decodeInto = measure(iterations, [&] {
+            return Message::decodeInto(*target, payload.c_str(), payload.length()) == DecodeStatus::Ok;
+        });
+        report(sample.name, "decinto", decodeInto);
+
+        Result decodeProjected = measure(iterations, [&] {
+            std::shared_ptr<Message> decoded = Message::translateJsonToStruct(payload.c_str(), payload.length(), 1);
+            return decoded && decoded->msgId != 0;
+        });
+        report(sample.name, "decproj", decodeProjected);
+
+        Result peek = measure(iterations, [&] {
+            MessageHeader header;
+            return Message::peekHeader(payload.c_str(), payload.length(), header) && header.msgType == message->msgType;
+        });
+        report(sample.name, "peek", peek);
+
+        char binary[512];
+        size_t binaryLength = message->serialize(binary, sizeof(binary), WireFormat::Binary);
+        Result encodeBinary = measure(iterations, [&] {
+            return message->serialize(buffer, sizeof(buffer), WireFormat::Binary) > 0;
+        });
+        report(sample.name, "encbin", encodeBinary);
+
+        Result decodeBinary = measure(iterations, [&] {
+            std::shared_ptr<Message> decoded = Message::translateJsonToStruct(binary, binaryLength);
+            return decoded && decoded->msgId != 0;
+        });
+        report(sample.name, "decbin", decodeBinary);
+
+        char msgPack[512];
+        size_t msgPackLength = message->serialize(msgPack, sizeof(msgPack), WireFormat::MsgPack);
+        Result encodeMsgPack = measure(iterations, [&] {
+            return message->serialize(buffer, sizeof(buffer), WireFormat::MsgPack) > 0;
+        });
+        report(sample.name, "encmsgpack", encodeMsgPack);
+
+        Result decodeMsgPack = measure(iterations, [&] {
+            std::shared_ptr<Message> decoded = Message::translateJsonToStruct(msgPack, msgPackLength);
+            return decoded && decoded->msgId != 0;
+        });
+        report(sample.name, "decmsgpack", decodeMsgPack);
+
+        MessageValue value = toMessageValue(*message);
+        Result encodeValue = measure(iterations, [&] {
+            return encodeMessageValue(value, buffer, sizeof(buffer)) > 0;
+        });
+        report(sample.name, "encvalue", encodeValue);
+
+        Result decodeValue = measure(iterations, [&] {
+            return decodeMessageValue(payload.c_str(), payload.length()).index() != 0;
+        });
+        report(sample.name, "decvalue", decodeValue);
+    }
+
+    // One burst of every sample, as individual payloads and as one JSON array frame
+    const size_t burstSize = sizeof(samples) / sizeof(samples[0]);
+    String encoded[burstSize];
+    MessagePayload payloads[burstSize];
+    String frame = "[";
+    for (size_t i = 0; i < burstSize; i++)
+    {
+        encoded[i] = samples[i].create()->parseStructToString();
+        payloads[i] = {encoded[i].c_str(), encoded[i].length()};
+        frame += (i ? "," : "") + encoded[i];
+    }
+    frame += "]";
+    std::shared_ptr<Message> decoded[burstSize];
+
+    Result decodeSingle = measure(iterations, [&] {
+        bool retVal = true;
+        for (size_t i = 0; i < burstSize; i++)
+        {
+            decoded[i] = Message::translateJsonToStruct(payloads[i].data, payloads[i].length);
+            retVal = retVal && decoded[i] && decoded[i]->msgId != 0;
+        }
+        return retVal;
+    });
+    report("Burst", "decode", decodeSingle);
+
+    Result decodeBatch = measure(iterations, [&] {
+        Message::BatchResult result = Message::translateBatch(payloads, burstSize, decoded);
+        return result.items == burstSize && result.failed == 0;
+    });
+    report("Burst", "decbatch", decodeBatch);
+
+    Result decodeArray = measure(iterations, [&] {
+        Message::BatchResult result = Message::translateJsonArray(frame.c_str(), frame.length(), decoded, burstSize);
+        return result.complete && result.items == burstSize && result.failed == 0;
+    });
+    report("Burst", "decarray", decodeArray);
+
+    // The same decodes with every structural scan backend the CPU supports
+    const StructuralBackend detected = MessageStructural::backend();
+    const struct
+    {
+        StructuralBackend backend;
+        const char* decode;
+        const char* array;
+    } backends[] = {{StructuralBackend::Scalar, "dec-scalar", "arr-scalar"},
+                    {StructuralBackend::Sse2, "dec-sse2", "arr-sse2"},
+                    {StructuralBackend::Avx2, "dec-avx2", "arr-avx2"}};
+    for (const auto& backend : backends)
+    {
+        if (!MessageStructural::select(backend.backend))
+        {
+            continue;
+        }
+        Result decodeBackend = measure(iterations, [&] {
+            bool retVal = true;
+            for (size_t i = 0; i < burstSize; i++)
+            {
+                decoded[i] = Message::translateJsonToStruct(payloads[i].data, payloads[i].length);
+                retVal = retVal && decoded[i] && decoded[i]->msgId != 0;
+            }
+            return retVal;
+        });
+        report("Burst", backend.decode, decodeBackend);
+        Result decodeArrayBackend = measure(iterations, [&] {
+            Message::BatchResult result = Message::translateJsonArray(frame.c_str(), frame.length(), decoded, burstSize);
+            return result.complete && result.items == burstSize && result.failed == 0;
+        });
+        report("Burst", backend.array, decodeArrayBackend);
+    }
+    MessageStructural::select(detected);
+
+    std::shared_ptr<Message> burst[burstSize];
+    for (size_t i = 0; i < burstSize; i++)
+    {
+        burst[i] = samples[i].create();
+    }
+    char frameBuffer[4096];
+    Result encodeBatch = measure(iterations, [&] {
+        return Message::serializeBatch(burst, burstSize, frameBuffer, sizeof(frameBuffer)) > 0;
+    });
+    report("Burst", "encbatch", encodeBatch);
+
+    char binaryFrame[4096];
+    size_t binaryFrameLength = Message::serializeBatch(burst, burstSize, binaryFrame, sizeof(binaryFrame), WireFormat::Binary);
+    Result encodeBinaryBatch = measure(iterations, [&] {
+        return Message::serializeBatch(burst, burstSize, frameBuffer, sizeof(frameBuffer), WireFormat::Binary) > 0;
+    });
+    report("Burst", "encbinbatch", encodeBinaryBatch);
+
+    Result decodeBinaryFrame = measure(iterations, [&] {
+        Message::BatchResult result = Message::translateFrame(binaryFrame, binaryFrameLength, decoded, burstSize);
+        return result.complete && result.items == burstSize && result.failed == 0;
+    });
+    report("Burst", "decbinframe", decodeBinaryFrame);
+
+    // The JSON array frame arriving in TCP-sized chunks
+    MessageStreamDecoder stream;
+    Result decodeStream = measure(iterations, [&] {
+        size_t received = 0;
+        for (size_t position = 0; position < frame.length();)
+        {
+            size_t chunk = frame.length() - position < 64 ? frame.length() - position : 64;
+            position += stream.feed(frame.c_str() + position, chunk);
+            while (stream.available() > 0)
+            {
+                DecodeStatus status;
+                std::shared_ptr<Message> message = stream.read(&status);
+                received += status == DecodeStatus::Ok ? 1 : 0;
+            }
+        }
+        return received == burstSize;
+    });
+    report("Burst", "decstream", decodeStream);
+
+    return 0;
+}
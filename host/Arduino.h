@@ -0,0 +1,187 @@
+/**
+ * @file Arduino.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Host port of the Arduino core parts used by the Messages library
+ * @version 0.1
+ * @date 2020-03-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * Only used for host builds (benchmark, gateway). Put this directory on the
+ * include path instead of an Arduino core and compile ArduinoJson with
+ * ARDUINOJSON_ENABLE_ARDUINO_STRING and ARDUINOJSON_ENABLE_ARDUINO_PRINT set.
+ *
+ */
+#ifndef HOST_ARDUINO_H__
+#define HOST_ARDUINO_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Milliseconds since the first call
+ *
+ * @return unsigned long
+ */
+inline unsigned long millis()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Stopped time of micros, tests use it to get exact durations
+ *
+ */
+struct HostClock
+{
+    bool frozen;                                ///< micros returns now instead of the elapsed time
+    unsigned long now;                          ///< microseconds while frozen
+};
+
+inline HostClock& hostClock()
+{
+    static HostClock clock = {false, 0};
+    return clock;
+}
+
+/**
+ * @brief Stop micros at a value until hostRunClock is called
+ *
+ * @param now - microseconds
+ */
+inline void hostFreezeClock(unsigned long now)
+{
+    hostClock().now = now;
+    hostClock().frozen = true;
+}
+
+inline void hostRunClock()
+{
+    hostClock().frozen = false;
+}
+
+/**
+ * @brief Microseconds since the first call, or the frozen time
+ *
+ * @return unsigned long
+ */
+inline unsigned long micros()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    if (hostClock().frozen)
+    {
+        return hostClock().now;
+    }
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Arduino String backed by std::string
+ *
+ * Implements the subset of the Arduino String interface used by the library
+ * and by the ArduinoJson string adapters.
+ *
+ */
+class String
+{
+private:
+
+    std::string buffer;                         ///< storage of the string
+
+public:
+
+    String(const char* cstr = "") : buffer(cstr ? cstr : "") {}
+    String(const char* cstr, unsigned int length) : buffer(cstr ? cstr : "", cstr ? length : 0) {}
+    explicit String(char c) : buffer(1, c) {}
+    explicit String(unsigned char value) : buffer(std::to_string((unsigned int)value)) {}
+    explicit String(int value) : buffer(std::to_string(value)) {}
+    explicit String(unsigned int value) : buffer(std::to_string(value)) {}
+    explicit String(long value) : buffer(std::to_string(value)) {}
+    explicit String(unsigned long value) : buffer(std::to_string(value)) {}
+
+    const char* c_str() const { return this->buffer.c_str(); }
+    unsigned int length() const { return (unsigned int)this->buffer.length(); }
+    bool reserve(unsigned int size) { this->buffer.reserve(size); return true; }
+
+    String& operator=(const char* cstr) { this->buffer = cstr ? cstr : ""; return *this; }
+
+    bool concat(const String& str) { this->buffer += str.buffer; return true; }
+    bool concat(const char* cstr) { if (cstr) this->buffer += cstr; return true; }
+    bool concat(const char* cstr, unsigned int length) { if (cstr) this->buffer.append(cstr, length); return true; }
+    bool concat(char c) { this->buffer += c; return true; }
+
+    String& operator+=(const String& str) { this->concat(str); return *this; }
+    String& operator+=(const char* cstr) { this->concat(cstr); return *this; }
+    String& operator+=(char c) { this->concat(c); return *this; }
+
+    friend String operator+(String lhs, const String& rhs) { lhs.concat(rhs); return lhs; }
+    friend String operator+(String lhs, const char* rhs) { lhs.concat(rhs); return lhs; }
+
+    char operator[](unsigned int index) const { return index < this->buffer.length() ? this->buffer[index] : 0; }
+    bool operator==(const String& rhs) const { return this->buffer == rhs.buffer; }
+    bool operator==(const char* rhs) const { return this->buffer == (rhs ? rhs : ""); }
+    bool operator!=(const String& rhs) const { return !(*this == rhs); }
+    bool operator!=(const char* rhs) const { return !(*this == rhs); }
+
+    long toInt() const { return std::strtol(this->buffer.c_str(), nullptr, 10); }
+};
+
+/**
+ * @brief Arduino Print interface
+ *
+ */
+class Print
+{
+public:
+
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+        {
+            n += this->write(*buffer++);
+        }
+        return n;
+    }
+
+    size_t write(const char* str) { return str ? this->write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t print(const char* str) { return this->write(str); }
+    size_t print(const String& str) { return this->write((const uint8_t*)str.c_str(), str.length()); }
+    size_t println(const char* str) { return this->print(str) + this->write((uint8_t)'\n'); }
+    size_t println(const String& str) { return this->print(str) + this->write((uint8_t)'\n'); }
+};
+
+/**
+ * @brief Arduino Stream interface
+ *
+ */
+class Stream : public Print
+{
+public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(char* buffer, size_t length)
+    {
+        size_t n = 0;
+        while (n < length && this->available() > 0)
+        {
+            buffer[n++] = (char)this->read();
+        }
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file LogConfiguration.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Host port of the logging macros used by the Messages library
+ * @version 0.1
+ * @date 2020-03-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * Logging is compiled out by default so that host measurements are not
+ * dominated by console output. Define MESSAGES_HOST_LOG to print to stdout.
+ *
+ */
+#ifndef HOST_LOGCONFIGURATION_H__
+#define HOST_LOGCONFIGURATION_H__
+
+#include <Arduino.h>
+
+#ifdef MESSAGES_HOST_LOG
+
+inline void hostLog(const char* text, bool newline) { std::fputs(text ? text : "(null)", stdout); if (newline) std::fputc('\n', stdout); }
+inline void hostLog(const String& text, bool newline) { hostLog(text.c_str(), newline); }
+inline void hostLog(long value, bool newline) { std::printf(newline ? "%ld\n" : "%ld", value); }
+inline void hostLog(unsigned long value, bool newline) { std::printf(newline ? "%lu\n" : "%lu", value); }
+inline void hostLog(int value, bool newline) { hostLog((long)value, newline); }
+inline void hostLog(unsigned int value, bool newline) { hostLog((unsigned long)value, newline); }
+
+#define DBFUNCCALL(x)       hostLog(x, false)
+#define DBFUNCCALLln(x)     hostLog(x, true)
+#define DBINFO1(x)          hostLog(x, false)
+#define DBINFO1ln(x)        hostLog(x, true)
+#define DBINFO2(x)          hostLog(x, false)
+#define DBINFO2ln(x)        hostLog(x, true)
+#define DBINFO3(x)          hostLog(x, false)
+#define DBINFO3ln(x)        hostLog(x, true)
+#define DBWARNING(x)        hostLog(x, false)
+#define DBWARNINGln(x)      hostLog(x, true)
+#define DBERROR(x)          hostLog(x, false)
+#define DBERRORln(x)        hostLog(x, true)
+
+#else
+
+#define DBFUNCCALL(x)       do {} while (0)
+#define DBFUNCCALLln(x)     do {} while (0)
+#define DBINFO1(x)          do {} while (0)
+#define DBINFO1ln(x)        do {} while (0)
+#define DBINFO2(x)          do {} while (0)
+#define DBINFO2ln(x)        do {} while (0)
+#define DBINFO3(x)          do {} while (0)
+#define DBINFO3ln(x)        do {} while (0)
+#define DBWARNING(x)        do {} while (0)
+#define DBWARNINGln(x)      do {} while (0)
+#define DBERROR(x)          do {} while (0)
+#define DBERRORln(x)        do {} while (0)
+
+#endif
+
+#endif
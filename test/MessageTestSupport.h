@@ -0,0 +1,192 @@
+/**
+ * @file MessageTestSupport.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Sample messages and field comparisons shared by the test suites
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef MESSAGETESTSUPPORT_H__
+#define MESSAGETESTSUPPORT_H__
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string>
+
+#include "MessageRegistry.h"
+#include "Messages.h"
+
+/**
+ * @brief Compare a DecodeStatus, Unity only knows integers
+ *
+ */
+#define TEST_ASSERT_STATUS(expected, actual) TEST_ASSERT_EQUAL_INT_MESSAGE((int)(expected), (int)(actual), "DecodeStatus")
+
+/**
+ * @brief Wire formats every message is tested in
+ *
+ */
+static const WireFormat TEST_FORMATS[] = {WireFormat::Json, WireFormat::Binary, WireFormat::MsgPack};
+
+/**
+ * @brief Set every specific field of a message to a value derived from its index and a seed
+ *
+ * Different seeds give different values in every field. Symbols use a small
+ * vocabulary, texts use up to the capacity of their field.
+ *
+ * @param message
+ * @param seed
+ */
+inline void fillFields(Message& message, unsigned int seed)
+{
+    MessageFieldTable table = RegisteredMessages::fields(message.msgType);
+    char* base = static_cast<char*>(RegisteredMessages::fieldsOf(message));
+    char text[64];
+    for (size_t i = 0; i < table.count; i++)
+    {
+        const MessageField& descriptor = table.fields[i];
+        void* member = base + descriptor.offset;
+        switch (descriptor.type)
+        {
+        case FieldType::Unsigned:
+            *static_cast<unsigned int*>(member) = 1000 * seed + (unsigned int)i;
+            break;
+        case FieldType::Signed:
+            *static_cast<int*>(member) = -(int)(1000 * seed + i);
+            break;
+        case FieldType::Boolean:
+            *static_cast<bool*>(member) = (seed + i) % 2 == 0;
+            break;
+        case FieldType::Text:
+            snprintf(text, sizeof(text), "text %u/%u:{,}", seed, (unsigned int)i);
+            FixedStringAccess::assign(member, descriptor.capacity, text, strlen(text));
+            break;
+        case FieldType::Symbol:
+            snprintf(text, sizeof(text), "symbol%u", (seed + (unsigned int)i) % 3);
+            *static_cast<MessageSymbol*>(member) = text;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Message of the given type from its pool with a frame and fields derived from a seed
+ *
+ * @param type
+ * @param seed
+ * @return std::shared_ptr<Message>
+ */
+inline std::shared_ptr<Message> sampleMessage(Message::MessageType type, unsigned int seed)
+{
+    std::shared_ptr<Message> retVal = RegisteredMessages::create(type);
+    retVal->msgId = 100 * seed + (unsigned int)type;
+    retVal->msgConsignor = (Consignor)(1 + seed % 7);
+    fillFields(*retVal, seed);
+    retVal->updateLength();
+    return retVal;
+}
+
+/**
+ * @brief Readable form of a field for assertion messages
+ *
+ * @param descriptor
+ * @param member
+ * @return std::string
+ */
+inline std::string fieldText(const MessageField& descriptor, const void* member)
+{
+    char text[64];
+    switch (descriptor.type)
+    {
+    case FieldType::Unsigned:
+        snprintf(text, sizeof(text), "%u", *static_cast<const unsigned int*>(member));
+        return text;
+    case FieldType::Signed:
+        snprintf(text, sizeof(text), "%d", *static_cast<const int*>(member));
+        return text;
+    case FieldType::Boolean:
+        return *static_cast<const bool*>(member) ? "true" : "false";
+    case FieldType::Text:
+        return FixedStringAccess::characters(member, descriptor.capacity);
+    case FieldType::Symbol:
+        return static_cast<const MessageSymbol*>(member)->c_str();
+    }
+    return "";
+}
+
+/**
+ * @brief Assert that two messages have the same frame and the same fields
+ *
+ * @param expected
+ * @param actual
+ * @param context - printed with a failure
+ */
+inline void assertSameMessage(Message& expected, Message& actual, const char* context = "")
+{
+    TEST_ASSERT_EQUAL_INT_MESSAGE((int)expected.msgType, (int)actual.msgType, context);
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(expected.msgId, actual.msgId, context);
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(expected.msgLength, actual.msgLength, context);
+    TEST_ASSERT_EQUAL_INT_MESSAGE((int)expected.msgConsignor, (int)actual.msgConsignor, context);
+    MessageFieldTable table = RegisteredMessages::fields(expected.msgType);
+    const char* left = static_cast<const char*>(RegisteredMessages::fieldsOf(expected));
+    const char* right = static_cast<const char*>(RegisteredMessages::fieldsOf(actual));
+    for (size_t i = 0; i < table.count; i++)
+    {
+        const MessageField& descriptor = table.fields[i];
+        std::string message = std::string(context) + " field " + descriptor.key;
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(fieldText(descriptor, left + descriptor.offset).c_str(),
+                                         fieldText(descriptor, right + descriptor.offset).c_str(), message.c_str());
+    }
+}
+
+/**
+ * @brief Encode a message into a string
+ *
+ * @param message
+ * @param format
+ * @return std::string
+ */
+inline std::string encode(const Message& message, WireFormat format = WireFormat::Json)
+{
+    char buffer[512];
+    size_t length = message.serialize(buffer, sizeof(buffer), format);
+    TEST_ASSERT_TRUE_MESSAGE(length > 0, "serialize failed");
+    return std::string(buffer, length);
+}
+
+/**
+ * @brief Decode a payload with a fresh document
+ *
+ * @param payload
+ * @param status
+ * @return std::shared_ptr<Message>
+ */
+inline std::shared_ptr<Message> decode(const std::string& payload, DecodeStatus& status, MessageFieldMask projection = MESSAGE_FIELDS_ALL)
+{
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    return Message::decode(payload.data(), payload.size(), document, status, projection);
+}
+
+/**
+ * @brief Outcome of a decode as text, to compare two decode paths
+ *
+ * @param message
+ * @param status
+ * @return std::string
+ */
+inline std::string outcome(const std::shared_ptr<Message>& message, DecodeStatus status)
+{
+    std::string retVal = std::to_string((int)status) + " ";
+    if (!message)
+    {
+        return retVal + "nullptr";
+    }
+    char buffer[512];
+    size_t length = message->serialize(buffer, sizeof(buffer));
+    return retVal + std::string(buffer, length);
+}
+
+#endif
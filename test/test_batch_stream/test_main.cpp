@@ -0,0 +1,341 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Batch frames and the stream decoder across chunk boundaries
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+#include "MessageStream.h"
+
+#include <vector>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * @brief One sample message of every type
+ *
+ * @param seed
+ * @return std::vector<std::shared_ptr<Message>>
+ */
+static std::vector<std::shared_ptr<Message>> everyType(unsigned int seed)
+{
+    std::vector<std::shared_ptr<Message>> retVal;
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        retVal.push_back(sampleMessage((Message::MessageType)type, seed));
+    }
+    return retVal;
+}
+
+//======================BATCH============================================================
+//=======================================================================================
+
+void test_batch_roundtrip_every_format()
+{
+    std::vector<std::shared_ptr<Message>> sent = everyType(2);
+    for (WireFormat format : TEST_FORMATS)
+    {
+        char frame[4096];
+        size_t length = Message::serializeBatch(sent.data(), sent.size(), frame, sizeof(frame), format);
+        TEST_ASSERT_TRUE(length > 0);
+        TEST_ASSERT_EQUAL_UINT(length, Message::measureBatch(sent.data(), sent.size(), format));
+
+        std::shared_ptr<Message> received[Message::MESSAGE_TYPES];
+        DecodeStatus status[Message::MESSAGE_TYPES];
+        Message::BatchResult result = Message::translateFrame(frame, length, received, Message::MESSAGE_TYPES, status);
+        TEST_ASSERT_TRUE(result.complete);
+        TEST_ASSERT_EQUAL_UINT(sent.size(), result.items);
+        TEST_ASSERT_EQUAL_UINT(0, result.failed);
+        for (size_t i = 0; i < sent.size(); i++)
+        {
+            TEST_ASSERT_STATUS(DecodeStatus::Ok, status[i]);
+            assertSameMessage(*sent[i], *received[i], "batch");
+        }
+    }
+}
+
+void test_batch_buffer_too_small()
+{
+    std::vector<std::shared_ptr<Message>> sent = everyType(3);
+    for (WireFormat format : TEST_FORMATS)
+    {
+        size_t length = Message::measureBatch(sent.data(), sent.size(), format);
+        std::vector<char> frame(length);
+        TEST_ASSERT_EQUAL_UINT(0, Message::serializeBatch(sent.data(), sent.size(), frame.data(), frame.size(), format));
+    }
+}
+
+void test_json_array_over_capacity_is_incomplete()
+{
+    std::vector<std::shared_ptr<Message>> sent = everyType(4);
+    char frame[4096];
+    size_t length = Message::serializeBatch(sent.data(), sent.size(), frame, sizeof(frame));
+    std::shared_ptr<Message> received[3];
+    Message::BatchResult result = Message::translateJsonArray(frame, length, received, 3);
+    TEST_ASSERT_FALSE(result.complete);
+    TEST_ASSERT_EQUAL_UINT(3, result.items);
+    for (size_t i = 0; i < 3; i++)
+    {
+        assertSameMessage(*sent[i], *received[i], "capacity");
+    }
+}
+
+void test_json_array_with_failed_items()
+{
+    const char* frame = "[{\"msgId\":1,\"msgType\":99,\"msgLength\":0,\"msgConsignor\":1}, 7, {\"msgId\":2,\"msgType\":2}]";
+    std::shared_ptr<Message> received[4];
+    DecodeStatus status[4];
+    Message::BatchResult result = Message::translateJsonArray(frame, strlen(frame), received, 4, status);
+    TEST_ASSERT_FALSE(result.complete);
+    TEST_ASSERT_EQUAL_UINT(1, result.items);
+    TEST_ASSERT_EQUAL_UINT(1, result.failed);
+    TEST_ASSERT_STATUS(DecodeStatus::UnknownType, status[0]);
+    TEST_ASSERT_NULL(received[0]);
+}
+
+void test_truncated_batch_frames()
+{
+    std::vector<std::shared_ptr<Message>> sent = everyType(5);
+    for (WireFormat format : TEST_FORMATS)
+    {
+        char frame[4096];
+        size_t length = Message::serializeBatch(sent.data(), sent.size(), frame, sizeof(frame), format);
+        for (size_t cut = 1; cut < length; cut += 7)
+        {
+            std::shared_ptr<Message> received[Message::MESSAGE_TYPES];
+            DecodeStatus status[Message::MESSAGE_TYPES];
+            Message::BatchResult result = Message::translateFrame(frame, cut, received, Message::MESSAGE_TYPES, status);
+            TEST_ASSERT_TRUE(!result.complete || result.failed > 0);
+            for (size_t i = 0; i < result.items; i++)
+            {
+                if (status[i] == DecodeStatus::Ok)
+                {
+                    assertSameMessage(*sent[i], *received[i], "truncated batch");
+                }
+            }
+        }
+    }
+}
+
+//======================STREAM===========================================================
+//=======================================================================================
+
+/**
+ * @brief Feed input in chunks of a fixed size and collect every decoded message
+ *
+ * @param decoder
+ * @param input
+ * @param chunk
+ * @param received
+ * @param statuses
+ */
+static void feedInChunks(MessageStreamDecoder& decoder, const std::string& input, size_t chunk,
+                         std::vector<std::shared_ptr<Message>>& received, std::vector<DecodeStatus>& statuses)
+{
+    size_t position = 0;
+    while (position < input.size() || decoder.available())
+    {
+        size_t length = input.size() - position < chunk ? input.size() - position : chunk;
+        position += decoder.feed(input.data() + position, length);
+        while (decoder.available())
+        {
+            DecodeStatus status;
+            received.push_back(decoder.read(&status));
+            statuses.push_back(status);
+        }
+    }
+}
+
+void test_stream_every_chunk_size()
+{
+    std::vector<std::shared_ptr<Message>> sent;
+    std::string input;
+    for (unsigned int seed = 1; seed <= 2; seed++)
+    {
+        for (WireFormat format : TEST_FORMATS)
+        {
+            for (std::shared_ptr<Message>& message : everyType(seed))
+            {
+                input += encode(*message, format);
+                if (format == WireFormat::Json)
+                {
+                    input += seed == 1 ? " \r\n" : ",";
+                }
+                sent.push_back(message);
+            }
+        }
+    }
+
+    for (size_t chunk = 1; chunk <= 97; chunk++)
+    {
+        MessageStreamDecoder decoder;
+        std::vector<std::shared_ptr<Message>> received;
+        std::vector<DecodeStatus> statuses;
+        feedInChunks(decoder, input, chunk, received, statuses);
+        char context[32];
+        snprintf(context, sizeof(context), "chunk %u", (unsigned int)chunk);
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(sent.size(), received.size(), context);
+        for (size_t i = 0; i < sent.size(); i++)
+        {
+            TEST_ASSERT_STATUS(DecodeStatus::Ok, statuses[i]);
+            assertSameMessage(*sent[i], *received[i], context);
+        }
+    }
+}
+
+void test_stream_json_array_frame()
+{
+    std::vector<std::shared_ptr<Message>> sent = everyType(6);
+    char frame[4096];
+    size_t length = Message::serializeBatch(sent.data(), sent.size(), frame, sizeof(frame));
+    for (size_t chunk : {1, 5, 64, 4096})
+    {
+        MessageStreamDecoder decoder;
+        std::vector<std::shared_ptr<Message>> received;
+        std::vector<DecodeStatus> statuses;
+        feedInChunks(decoder, std::string(frame, length), chunk, received, statuses);
+        TEST_ASSERT_EQUAL_UINT(sent.size(), received.size());
+        for (size_t i = 0; i < sent.size(); i++)
+        {
+            assertSameMessage(*sent[i], *received[i], "array");
+        }
+    }
+}
+
+void test_stream_feed_stops_at_full_queue()
+{
+    std::string input;
+    for (size_t i = 0; i < MESSAGE_STREAM_QUEUE_SIZE + 2; i++)
+    {
+        input += encode(*sampleMessage(Message::MessageType::SBState, (unsigned int)i), WireFormat::Binary);
+    }
+    MessageStreamDecoder decoder;
+    size_t consumed = decoder.feed(input.data(), input.size());
+    TEST_ASSERT_TRUE(consumed < input.size());
+    TEST_ASSERT_EQUAL_UINT(MESSAGE_STREAM_QUEUE_SIZE, decoder.available());
+    while (decoder.available())
+    {
+        decoder.read();
+    }
+    TEST_ASSERT_EQUAL_UINT(input.size() - consumed, decoder.feed(input.data() + consumed, input.size() - consumed));
+    TEST_ASSERT_EQUAL_UINT(2, decoder.available());
+}
+
+void test_stream_oversized_json_is_rejected()
+{
+    std::string oversized = "{\"msgId\":1,\"msgType\":1,\"pad\":\"" + std::string(MESSAGE_STREAM_BUFFER_SIZE, 'p') + "\"}";
+    std::shared_ptr<Message> after = sampleMessage(Message::MessageType::SBAvailable, 1);
+    std::string input = oversized + encode(*after);
+    for (size_t chunk : {1, 16, 100})
+    {
+        MessageStreamDecoder decoder;
+        std::vector<std::shared_ptr<Message>> received;
+        std::vector<DecodeStatus> statuses;
+        feedInChunks(decoder, input, chunk, received, statuses);
+        TEST_ASSERT_TRUE(received.size() >= 2);
+        TEST_ASSERT_STATUS(DecodeStatus::NoMemory, statuses[0]);
+        TEST_ASSERT_NULL(received[0]);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, statuses.back());
+        assertSameMessage(*after, *received.back(), "after oversized");
+    }
+}
+
+/**
+ * @brief Replace the text of a field in an encoded message by a longer one
+ *
+ * @param payload
+ * @param format
+ * @param text - text in the payload
+ * @param replacement
+ * @return std::string
+ */
+static std::string replaceText(const std::string& payload, WireFormat format, const char* text, const std::string& replacement)
+{
+    size_t position = payload.find(text);
+    TEST_ASSERT_TRUE(position != std::string::npos && position > 0);
+    size_t length = replacement.size();
+    std::string header;
+    if (format == WireFormat::Binary)
+    {
+        for (size_t rest = length; ; rest >>= 7)
+        {
+            header += (char)((rest & 0x7F) | (rest > 0x7F ? 0x80 : 0));
+            if (rest <= 0x7F)
+            {
+                break;
+            }
+        }
+    }
+    else if (format == WireFormat::MsgPack)
+    {
+        header = std::string(1, (char)0xDA) + (char)(length >> 8) + (char)(length & 0xFF);
+    }
+    size_t start = format == WireFormat::Json ? position : position - 1;
+    return payload.substr(0, start) + header + replacement + payload.substr(position + strlen(text));
+}
+
+void test_stream_resyncs_after_oversized_message()
+{
+    // MessagePack map headers, the binary magic and braces must not start a message
+    std::string filler;
+    for (size_t i = 0; filler.size() < 2 * MESSAGE_STREAM_BUFFER_SIZE; i++)
+    {
+        filler += (char)(0x80 + i % 16);
+        filler += i % 5 == 0 ? "{\\\"" : i % 7 == 0 ? "\xC1\xDE}" : "a";
+    }
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::Package, 7);
+    std::shared_ptr<Message> after = sampleMessage(Message::MessageType::SBAvailable, 1);
+    const char* text = static_cast<PackageMessage&>(*sent).targetDest.c_str();
+    for (WireFormat format : TEST_FORMATS)
+    {
+        std::string oversized = replaceText(encode(*sent, format), format, text, filler);
+        std::string input = oversized + encode(*after, format) + oversized + encode(*after);
+        for (size_t chunk : {1, 3, 16, 100, 511, 512, 513, 4096})
+        {
+            MessageStreamDecoder decoder;
+            std::vector<std::shared_ptr<Message>> received;
+            std::vector<DecodeStatus> statuses;
+            feedInChunks(decoder, input, chunk, received, statuses);
+            char context[40];
+            snprintf(context, sizeof(context), "format %u chunk %u", (unsigned int)format, (unsigned int)chunk);
+            TEST_ASSERT_EQUAL_UINT_MESSAGE(4, received.size(), context);
+            for (size_t i = 0; i < 4; i += 2)
+            {
+                // a message that lies within one chunk is decoded in place
+                if (chunk < oversized.size())
+                {
+                    TEST_ASSERT_STATUS(DecodeStatus::NoMemory, statuses[i]);
+                }
+                TEST_ASSERT_TRUE_MESSAGE(statuses[i] != DecodeStatus::Ok, context);
+                TEST_ASSERT_STATUS(DecodeStatus::Ok, statuses[i + 1]);
+                assertSameMessage(*after, *received[i + 1], context);
+            }
+        }
+    }
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_roundtrip_every_format);
+    RUN_TEST(test_batch_buffer_too_small);
+    RUN_TEST(test_json_array_over_capacity_is_incomplete);
+    RUN_TEST(test_json_array_with_failed_items);
+    RUN_TEST(test_truncated_batch_frames);
+    RUN_TEST(test_stream_every_chunk_size);
+    RUN_TEST(test_stream_json_array_frame);
+    RUN_TEST(test_stream_feed_stops_at_full_queue);
+    RUN_TEST(test_stream_oversized_json_is_rejected);
+    RUN_TEST(test_stream_resyncs_after_oversized_message);
+    return UNITY_END();
+}
@@ -0,0 +1,411 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Round trips and decode errors of single messages in every wire format
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+
+#include <limits.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+//======================ROUNDTRIP========================================================
+//=======================================================================================
+
+void test_roundtrip_every_type_and_format()
+{
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        for (WireFormat format : TEST_FORMATS)
+        {
+            std::shared_ptr<Message> sent = sampleMessage((Message::MessageType)type, 3);
+            std::string payload = encode(*sent, format);
+            TEST_ASSERT_EQUAL_UINT(payload.size(), sent->measure(format));
+            TEST_ASSERT_TRUE(detectWireFormat(payload.data(), payload.size()) == format);
+
+            DecodeStatus status;
+            std::shared_ptr<Message> received = decode(payload, status);
+            char context[32];
+            snprintf(context, sizeof(context), "type %u format %u", (unsigned int)type, (unsigned int)format);
+            TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+            TEST_ASSERT_NOT_NULL(received);
+            assertSameMessage(*sent, *received, context);
+        }
+    }
+}
+
+void test_translate_json_to_struct_matches_decode()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SBToSOHandshake, 5);
+    String payload = sent->parseStructToString();
+    TEST_ASSERT_EQUAL_UINT(payload.length(), sent->msgLength);
+    std::shared_ptr<Message> received = Message::translateJsonToStruct(payload.c_str(), payload.length());
+    TEST_ASSERT_NOT_NULL(received);
+    assertSameMessage(*sent, *received);
+}
+
+void test_legacy_quoted_numbers_and_booleans()
+{
+    const char* payload = "{\"msgId\":\"7\",\"msgType\":\"2\",\"msgLength\":\"0\",\"msgConsignor\":\"3\",\"error\":\"1\",\"token\":\"0\"}";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_NOT_NULL(received);
+    ErrorMessage& error = static_cast<ErrorMessage&>(*received);
+    TEST_ASSERT_EQUAL_UINT(7, error.msgId);
+    TEST_ASSERT_EQUAL_INT((int)Consignor::SB2, (int)error.msgConsignor);
+    TEST_ASSERT_TRUE(error.error);
+    TEST_ASSERT_FALSE(error.token);
+}
+
+void test_escaped_and_reordered_members()
+{
+    const char* payload = "{ \"cargo\" : \"c\\\"1\", \"msgType\":1, \"packageId\":42, \"msgId\":9,"
+                          "\"targetDest\":\"a\\\\b\", \"extra\":{\"a\":[1,2]}, \"msgLength\":0, \"msgConsignor\":1, \"targetReg\":\"r\" }";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    PackageMessage& package = static_cast<PackageMessage&>(*received);
+    TEST_ASSERT_EQUAL_UINT(9, package.msgId);
+    TEST_ASSERT_EQUAL_UINT(42, package.packageId);
+    TEST_ASSERT_EQUAL_STRING("c\"1", package.cargo.c_str());
+    TEST_ASSERT_EQUAL_STRING("a\\b", package.targetDest.c_str());
+    TEST_ASSERT_EQUAL_STRING("r", package.targetReg.c_str());
+}
+
+void test_duplicate_keys_keep_the_first_value()
+{
+    const char* payload = "{\"msgId\":9,\"msgType\":4,\"msgLength\":0,\"msgConsignor\":2,\"line\":3,"
+                          "\"sector\":\"sector1\",\"line\":5,\"sector\":\"sector2\",\"msgId\":10}";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    SBPositionMessage& position = static_cast<SBPositionMessage&>(*received);
+    TEST_ASSERT_EQUAL_UINT(9, position.msgId);
+    TEST_ASSERT_EQUAL_INT(3, position.line);
+    TEST_ASSERT_EQUAL_STRING("sector1", position.sector.c_str());
+
+    // a null first value still wins, like the lookup of the key
+    received = decode("{\"msgId\":4,\"msgType\":1,\"msgLength\":0,\"msgConsignor\":1,\"packageId\":2,\"cargo\":null,\"cargo\":\"c\"}", status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_STRING("null", static_cast<PackageMessage&>(*received).cargo.c_str());
+}
+
+void test_missing_and_null_strings_read_as_null()
+{
+    for (const char* payload : {"{\"msgId\":4,\"msgType\":1,\"msgLength\":0,\"msgConsignor\":1,\"packageId\":2}",
+                                "{\"msgId\":4,\"msgType\":1,\"msgLength\":0,\"msgConsignor\":1,\"packageId\":2,\"cargo\":null,\"targetDest\":null,\"targetReg\":null}"})
+    {
+        DecodeStatus status;
+        std::shared_ptr<Message> received = decode(payload, status);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+        PackageMessage& package = static_cast<PackageMessage&>(*received);
+        TEST_ASSERT_EQUAL_STRING("null", package.cargo.c_str());
+        TEST_ASSERT_TRUE(package.cargo.seeded());
+        TEST_ASSERT_EQUAL_STRING("null", package.targetDest.c_str());
+        TEST_ASSERT_EQUAL_STRING("null", package.targetReg.c_str());
+    }
+}
+
+//======================ERRORS===========================================================
+//=======================================================================================
+
+void test_unknown_type()
+{
+    for (const char* payload : {"{\"msgId\":1,\"msgType\":99,\"msgLength\":0,\"msgConsignor\":1}",
+                                "{\"msgId\":1,\"msgLength\":0,\"msgConsignor\":1}"})
+    {
+        DecodeStatus status;
+        TEST_ASSERT_NULL(decode(payload, status));
+        TEST_ASSERT_STATUS(DecodeStatus::UnknownType, status);
+    }
+    char binary[] = {(char)MESSAGE_BINARY_MAGIC, 1, 99, 0, 1};
+    DecodeStatus status;
+    TEST_ASSERT_NULL(decode(std::string(binary, sizeof(binary)), status));
+    TEST_ASSERT_STATUS(DecodeStatus::UnknownType, status);
+}
+
+void test_malformed_json()
+{
+    for (const char* payload : {"", "{", "not json", "{\"msgId\":1,\"msgType\":2,", "{\"msgId\":1 \"msgType\":2}"})
+    {
+        DecodeStatus status;
+        std::shared_ptr<Message> received = decode(payload, status);
+        TEST_ASSERT_TRUE_MESSAGE(status == DecodeStatus::Malformed || status == DecodeStatus::UnknownType, payload);
+        TEST_ASSERT_TRUE_MESSAGE(!received || received->msgId == 0, payload);
+    }
+}
+
+void test_truncated_payloads_fail()
+{
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        for (WireFormat format : TEST_FORMATS)
+        {
+            std::string payload = encode(*sampleMessage((Message::MessageType)type, 4), format);
+            for (size_t length = 0; length < payload.size(); length++)
+            {
+                DecodeStatus status;
+                std::shared_ptr<Message> received = decode(payload.substr(0, length), status);
+                TEST_ASSERT_TRUE(status != DecodeStatus::Ok);
+                TEST_ASSERT_TRUE(!received || received->msgId == 0);
+            }
+        }
+    }
+}
+
+void test_out_of_range_varints_are_malformed()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SBPosition, 2);
+    sent->msgId = UINT_MAX;
+    static_cast<SBPositionMessage&>(*sent).line = INT_MIN;
+    std::string payload = encode(*sent, WireFormat::Binary);
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_UINT(UINT_MAX, received->msgId);
+    TEST_ASSERT_EQUAL_INT(INT_MIN, static_cast<SBPositionMessage&>(*received).line);
+
+    // msgId is the first varint after the magic byte, the line the last one
+    std::string wideId = payload;
+    wideId[5] = 0x1F;
+    decode(wideId, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Malformed, status);
+
+    std::string wideLine = payload;
+    wideLine[wideLine.size() - 1] = 0x1F;
+    decode(wideLine, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Malformed, status);
+
+    // eleven groups do not fit an unsigned long anywhere
+    std::string overlong = payload.substr(0, 1) + std::string(10, (char)0xFF) + std::string(1, 0x01) + payload.substr(6);
+    decode(overlong, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Malformed, status);
+}
+
+void test_oversized_text_is_invalid()
+{
+    std::string payload = "{\"msgId\":5,\"msgType\":1,\"msgLength\":0,\"msgConsignor\":1,\"packageId\":1,\"cargo\":\"a\",\"targetDest\":\"" +
+                          std::string(MESSAGE_REGION_LENGTH + 1, 'z') + "\",\"targetReg\":\"c\"}";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Invalid, status);
+    TEST_ASSERT_NOT_NULL(received);
+    TEST_ASSERT_EQUAL_UINT(0, received->msgId);
+
+    payload.replace(payload.find(std::string(MESSAGE_REGION_LENGTH + 1, 'z')), MESSAGE_REGION_LENGTH + 1, std::string(MESSAGE_REGION_LENGTH, 'z'));
+    received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_UINT(MESSAGE_REGION_LENGTH, static_cast<PackageMessage&>(*received).targetDest.length());
+}
+
+void test_fixed_string_length_fits_capacity()
+{
+    static_assert(sizeof(FixedString<MESSAGE_HANDSHAKE_LENGTH>) == 1 + MESSAGE_HANDSHAKE_LENGTH + 1, "one length byte up to 255 characters");
+    FixedString<300> wide;
+    std::string text(280, 'x');
+    TEST_ASSERT_TRUE(wide.assign(text.data(), text.size()));
+    TEST_ASSERT_EQUAL_UINT(280, FixedStringAccess::length(&wide, wide.capacity()));
+    TEST_ASSERT_EQUAL_STRING(text.c_str(), FixedStringAccess::characters(&wide, wide.capacity()));
+
+    // setMessage truncates to the capacity instead of failing
+    PackageMessage message;
+    message.setMessage(1, Consignor::SO1, 2, "a", std::string(MESSAGE_REGION_LENGTH + 3, 'z').c_str(), "c");
+    TEST_ASSERT_EQUAL_UINT(MESSAGE_REGION_LENGTH, message.targetDest.length());
+    TEST_ASSERT_EQUAL_STRING(std::string(MESSAGE_REGION_LENGTH, 'z').c_str(), message.targetDest.c_str());
+}
+
+//======================PROJECTION=======================================================
+//=======================================================================================
+
+void test_projection_reads_only_selected_fields()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SOInit, 6);
+    MessageFieldMask projection = SOInitMessage::Fields::table().mask("line") | SOInitMessage::Fields::table().mask("packageId");
+    TEST_ASSERT_TRUE(projection != 0);
+    for (WireFormat format : TEST_FORMATS)
+    {
+        DecodeStatus status;
+        std::shared_ptr<Message> received = decode(encode(*sent, format), status, projection);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+        SOInitMessage expected;
+        expected.msgId = sent->msgId;
+        expected.msgLength = sent->msgLength;
+        expected.msgConsignor = sent->msgConsignor;
+        expected.line = static_cast<SOInitMessage&>(*sent).line;
+        expected.packageId = static_cast<SOInitMessage&>(*sent).packageId;
+        assertSameMessage(expected, *received, "projection");
+    }
+}
+
+void test_projected_fields_may_be_missing()
+{
+    const char* payload = "{\"msgId\":3,\"msgType\":11,\"msgLength\":0,\"msgConsignor\":1,\"line\":4}";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status, SOPositionMessage::Fields::table().mask("line"));
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_INT(4, static_cast<SOPositionMessage&>(*received).line);
+}
+
+//======================FASTPATH=========================================================
+//=======================================================================================
+
+/**
+ * @brief Decode with the flat fast path and with the document and compare the outcomes
+ *
+ * @param payload
+ * @param projection
+ */
+static void assertPathsAgree(const std::string& payload, MessageFieldMask projection = MESSAGE_FIELDS_ALL)
+{
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    DecodeStatus fastStatus;
+    DecodeStatus documentStatus;
+    std::shared_ptr<Message> fast = Message::decode(payload.data(), payload.size(), document, fastStatus, projection);
+    std::string fastOutcome = outcome(fast, fastStatus);
+    std::shared_ptr<Message> slow = Message::decodeDocument(payload.data(), payload.size(), document, documentStatus, projection);
+    std::string slowOutcome = outcome(slow, documentStatus);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(slowOutcome.c_str(), fastOutcome.c_str(), payload.c_str());
+}
+
+void test_flat_path_matches_document_path()
+{
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        std::string payload = encode(*sampleMessage((Message::MessageType)type, 7));
+        assertPathsAgree(payload);
+        assertPathsAgree(payload, 1);
+        for (size_t i = 0; i < payload.size(); i++)
+        {
+            for (char c : {'"', '\\', '{', '[', ',', ':', '1', '-', ' ', 'x', '}', '0', '\x01'})
+            {
+                std::string mutated = payload;
+                mutated[i] = c;
+                assertPathsAgree(mutated);
+            }
+            assertPathsAgree(payload.substr(0, i) + payload.substr(i + 1));
+        }
+        assertPathsAgree(payload.substr(0, 1) + "\"extra\":{\"a\":[1,2]}," + payload.substr(1));
+        assertPathsAgree(payload.substr(0, 1) + " \"extra\" : \"x\\\"y\" , " + payload.substr(1));
+        assertPathsAgree(payload.substr(0, payload.size() - 1) + ",\"msgId\":1}");
+        assertPathsAgree(payload + "  \n");
+        assertPathsAgree(payload + "x");
+    }
+}
+
+//======================PEEK=============================================================
+//=======================================================================================
+
+void test_peek_header_every_format()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SVPosition, 8);
+    for (WireFormat format : TEST_FORMATS)
+    {
+        std::string payload = encode(*sent, format);
+        MessageHeader header;
+        TEST_ASSERT_TRUE(Message::peekHeader(payload.data(), payload.size(), header));
+        TEST_ASSERT_EQUAL_UINT(sent->msgId, header.msgId);
+        TEST_ASSERT_EQUAL_INT((int)sent->msgType, (int)header.msgType);
+        TEST_ASSERT_EQUAL_UINT(sent->msgLength, header.msgLength);
+        TEST_ASSERT_EQUAL_INT((int)sent->msgConsignor, (int)header.msgConsignor);
+    }
+    MessageHeader header;
+    TEST_ASSERT_FALSE(Message::peekHeader("{\"msgId\":1,", 11, header));
+}
+
+//======================DECODEINTO=======================================================
+//=======================================================================================
+
+void test_decode_into_overwrites_in_place()
+{
+    for (WireFormat format : TEST_FORMATS)
+    {
+        std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SBState, 9);
+        SBStateMessage target;
+        fillFields(target, 2);
+        std::string payload = encode(*sent, format);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, Message::decodeInto(target, payload.data(), payload.size()));
+        assertSameMessage(*sent, target, "decodeInto");
+    }
+}
+
+void test_decode_into_wrong_type_leaves_message_unchanged()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SVPosition, 1);
+    SBStateMessage target;
+    target.msgId = 77;
+    fillFields(target, 2);
+    SBStateMessage before = target;
+    for (WireFormat format : TEST_FORMATS)
+    {
+        std::string payload = encode(*sent, format);
+        TEST_ASSERT_STATUS(DecodeStatus::WrongType, Message::decodeInto(target, payload.data(), payload.size()));
+        assertSameMessage(before, target, "WrongType");
+    }
+}
+
+void test_decode_into_failed_payload_keeps_fields()
+{
+    std::string payload = encode(*sampleMessage(Message::MessageType::SBToSVHandshake, 3));
+    for (size_t length = payload.find(",\"", payload.find("msgConsignor")); length < payload.size(); length++)
+    {
+        SBToSVHandshakeMessage target;
+        target.msgId = 77;
+        fillFields(target, 2);
+        SBToSVHandshakeMessage before = target;
+        TEST_ASSERT_TRUE(Message::decodeInto(target, payload.data(), length) != DecodeStatus::Ok);
+        before.msgId = target.msgId;
+        assertSameMessage(before, target, "failed decodeInto");
+    }
+}
+
+void test_decode_into_malformed_payload_zeroes_msg_id()
+{
+    std::string json = encode(*sampleMessage(Message::MessageType::SBState, 4));
+    std::string binary = encode(*sampleMessage(Message::MessageType::SBState, 4), WireFormat::Binary);
+    const std::string payloads[] = {"{", "not json", "{\"msgId\":5,", json.substr(0, json.find("msgConsignor")), binary.substr(0, 2)};
+    for (const std::string& payload : payloads)
+    {
+        SBStateMessage target;
+        target.msgId = 77;
+        TEST_ASSERT_TRUE_MESSAGE(Message::decodeInto(target, payload.data(), payload.size()) != DecodeStatus::Ok, payload.c_str());
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(0, target.msgId, payload.c_str());
+    }
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip_every_type_and_format);
+    RUN_TEST(test_translate_json_to_struct_matches_decode);
+    RUN_TEST(test_legacy_quoted_numbers_and_booleans);
+    RUN_TEST(test_escaped_and_reordered_members);
+    RUN_TEST(test_duplicate_keys_keep_the_first_value);
+    RUN_TEST(test_missing_and_null_strings_read_as_null);
+    RUN_TEST(test_unknown_type);
+    RUN_TEST(test_malformed_json);
+    RUN_TEST(test_truncated_payloads_fail);
+    RUN_TEST(test_out_of_range_varints_are_malformed);
+    RUN_TEST(test_oversized_text_is_invalid);
+    RUN_TEST(test_fixed_string_length_fits_capacity);
+    RUN_TEST(test_projection_reads_only_selected_fields);
+    RUN_TEST(test_projected_fields_may_be_missing);
+    RUN_TEST(test_flat_path_matches_document_path);
+    RUN_TEST(test_peek_header_every_format);
+    RUN_TEST(test_decode_into_overwrites_in_place);
+    RUN_TEST(test_decode_into_wrong_type_leaves_message_unchanged);
+    RUN_TEST(test_decode_into_failed_payload_keeps_fields);
+    RUN_TEST(test_decode_into_malformed_payload_zeroes_msg_id);
+    return UNITY_END();
+}
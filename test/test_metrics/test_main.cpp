@@ -0,0 +1,169 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Metrics of a known mix of payloads and their JSON and binary reports
+ * @version 0.1
+ * @date 2020-06-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * The host clock is frozen, so every decode and encode takes zero
+ * microseconds and the other buckets are filled with exact durations.
+ *
+ */
+#include "../MessageTestSupport.h"
+
+#include "MessageMetrics.h"
+
+/**
+ * @brief Frozen time of the host clock
+ *
+ */
+static const unsigned long NOW = 5000000;
+
+/**
+ * @brief Print into a string
+ *
+ */
+class StringPrint : public Print
+{
+public:
+
+    std::string text;
+
+    size_t write(uint8_t c) override
+    {
+        this->text += (char)c;
+        return 1;
+    }
+};
+
+void setUp()
+{
+    hostFreezeClock(NOW);
+    MessageMetrics::reset();
+}
+
+void tearDown()
+{
+    hostRunClock();
+}
+
+static void decodePayload(const char* payload)
+{
+    DecodeStatus status;
+    decode(payload, status);
+}
+
+/**
+ * @brief Decode and encode a known mix and record durations on both sides of the bucket bounds
+ *
+ * type 0: a payload that is no JSON and one of an unknown type
+ * type 4: two decodes of 78 bytes, one encode and one encode into a too small buffer
+ * type 11: one decode of 64 bytes
+ * type 14: decodes of 15, 16, 63, 64, 1023, 1024 and 4000000 us, encodes of 511 and 512 us
+ *
+ */
+static void recordKnownMix()
+{
+    const char* position = "{\"msgId\":1,\"msgType\":4,\"msgLength\":0,\"msgConsignor\":0,\"sector\":\"-1\",\"line\":-1}";
+    decodePayload(position);
+    decodePayload("{\"msgId\":2,\"msgType\":11,\"msgLength\":0,\"msgConsignor\":0,\"line\":5}");
+    decodePayload("garbage");
+    decodePayload("{\"msgId\":4,\"msgType\":99,\"msgLength\":0,\"msgConsignor\":0}");
+
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(position, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    char buffer[128];
+    TEST_ASSERT_EQUAL_UINT(78, received->serialize(buffer, sizeof(buffer)));
+    received->serialize(buffer, 16);
+
+    for (unsigned long elapsed : {15ul, 16ul, 63ul, 64ul, 1023ul, 1024ul, 4000000ul})
+    {
+        MessageMetrics::recordDecode((Message::MessageType)14, 10, true, (uint32_t)(NOW - elapsed));
+    }
+    for (unsigned long elapsed : {511ul, 512ul})
+    {
+        MessageMetrics::recordEncode((Message::MessageType)14, 3, true, (uint32_t)(NOW - elapsed));
+    }
+}
+
+void test_metrics_of_a_known_mix()
+{
+    recordKnownMix();
+    MessageMetricsSnapshot snapshot;
+    MessageMetrics::snapshot(snapshot);
+
+    const MessageTypeMetrics& unreadable = snapshot.types[0];
+    TEST_ASSERT_EQUAL_UINT(0, unreadable.decoded);
+    TEST_ASSERT_EQUAL_UINT(2, unreadable.decodeErrors);
+    TEST_ASSERT_EQUAL_UINT(62, unreadable.bytesIn);
+
+    const MessageTypeMetrics& position = snapshot.types[4];
+    TEST_ASSERT_EQUAL_UINT(2, position.decoded);
+    TEST_ASSERT_EQUAL_UINT(1, position.encoded);
+    TEST_ASSERT_EQUAL_UINT(1, position.encodeErrors);
+    TEST_ASSERT_EQUAL_UINT(156, position.bytesIn);
+    TEST_ASSERT_EQUAL_UINT(78, position.bytesOut);
+
+    const uint32_t decodeLatency[MESSAGE_METRICS_BUCKETS] = {1, 1, 1, 1, 0, 0, 1, 2};
+    const uint32_t encodeLatency[MESSAGE_METRICS_BUCKETS] = {0, 0, 0, 0, 0, 1, 1, 0};
+    TEST_ASSERT_EQUAL_MEMORY(decodeLatency, snapshot.types[14].decodeLatency, sizeof(decodeLatency));
+    TEST_ASSERT_EQUAL_MEMORY(encodeLatency, snapshot.types[14].encodeLatency, sizeof(encodeLatency));
+}
+
+void test_json_report_of_a_known_mix()
+{
+    recordKnownMix();
+    StringPrint output;
+    size_t length = MessageMetrics::reportJson(output);
+    TEST_ASSERT_EQUAL_STRING("{\"buckets\":[16,32,64,128,256,512,1024],\"types\":["
+                             "{\"type\":0,\"decoded\":0,\"decodeErrors\":2,\"encoded\":0,\"encodeErrors\":0,\"bytesIn\":62,\"bytesOut\":0,"
+                             "\"decodeLatency\":[2,0,0,0,0,0,0,0],\"encodeLatency\":[0,0,0,0,0,0,0,0]},"
+                             "{\"type\":4,\"decoded\":2,\"decodeErrors\":0,\"encoded\":1,\"encodeErrors\":1,\"bytesIn\":156,\"bytesOut\":78,"
+                             "\"decodeLatency\":[2,0,0,0,0,0,0,0],\"encodeLatency\":[2,0,0,0,0,0,0,0]},"
+                             "{\"type\":11,\"decoded\":1,\"decodeErrors\":0,\"encoded\":0,\"encodeErrors\":0,\"bytesIn\":64,\"bytesOut\":0,"
+                             "\"decodeLatency\":[1,0,0,0,0,0,0,0],\"encodeLatency\":[0,0,0,0,0,0,0,0]},"
+                             "{\"type\":14,\"decoded\":7,\"decodeErrors\":0,\"encoded\":2,\"encodeErrors\":0,\"bytesIn\":70,\"bytesOut\":6,"
+                             "\"decodeLatency\":[1,1,1,1,0,0,1,2],\"encodeLatency\":[0,0,0,0,0,1,1,0]}]}",
+                             output.text.c_str());
+    TEST_ASSERT_EQUAL_UINT(output.text.size(), length);
+}
+
+void test_binary_report_of_a_known_mix()
+{
+    recordKnownMix();
+    StringPrint output;
+    size_t length = MessageMetrics::reportBinary(output);
+    const uint8_t expected[] = {
+        8, 16, 4,
+        0, 0, 2, 0, 0, 62, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        4, 2, 0, 1, 1, 0x9C, 0x01, 78, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0,
+        11, 1, 0, 0, 0, 64, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        14, 7, 0, 2, 0, 70, 6, 1, 1, 1, 1, 0, 0, 1, 2, 0, 0, 0, 0, 0, 1, 1, 0};
+    TEST_ASSERT_EQUAL_UINT(sizeof(expected), output.text.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, output.text.data(), sizeof(expected));
+    TEST_ASSERT_EQUAL_UINT(sizeof(expected), length);
+}
+
+void test_reports_without_activity()
+{
+    StringPrint json;
+    MessageMetrics::reportJson(json);
+    TEST_ASSERT_EQUAL_STRING("{\"buckets\":[16,32,64,128,256,512,1024],\"types\":[]}", json.text.c_str());
+
+    StringPrint binary;
+    TEST_ASSERT_EQUAL_UINT(3, MessageMetrics::reportBinary(binary));
+    TEST_ASSERT_EQUAL_MEMORY("\x08\x10\x00", binary.text.data(), 3);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_metrics_of_a_known_mix);
+    RUN_TEST(test_json_report_of_a_known_mix);
+    RUN_TEST(test_binary_report_of_a_known_mix);
+    RUN_TEST(test_reports_without_activity);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Decoded messages come from the pools and a steady receive loop stays off the heap
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+
+#include <stdlib.h>
+#include <new>
+
+/**
+ * @brief Number of heap allocations of the test binary
+ *
+ */
+static size_t allocations = 0;
+
+// GCC pairs the free below with the new expressions it inlines into, they are replaced together here
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* retVal = malloc(size ? size : 1);
+    if (!retVal)
+    {
+        throw std::bad_alloc();
+    }
+    return retVal;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * @brief Formats decoded without a JsonDocument, MessagePack memory is bounded by the document instead
+ *
+ */
+static const WireFormat DIRECT_FORMATS[] = {WireFormat::Json, WireFormat::Binary};
+
+void test_steady_decode_loop_does_not_allocate()
+{
+    for (WireFormat format : DIRECT_FORMATS)
+    {
+        std::string payloads[Message::MESSAGE_TYPES];
+        for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+        {
+            payloads[type - 1] = encode(*sampleMessage((Message::MessageType)type, 3), format);
+        }
+        StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+        DecodeStatus status;
+        for (const std::string& payload : payloads)
+        {
+            Message::decode(payload.data(), payload.size(), document, status);
+        }
+
+        size_t before = allocations;
+        for (size_t round = 0; round < 50; round++)
+        {
+            for (const std::string& payload : payloads)
+            {
+                std::shared_ptr<Message> received = Message::decode(payload.data(), payload.size(), document, status);
+                TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+            }
+        }
+        char context[32];
+        snprintf(context, sizeof(context), "format %d", (int)format);
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(0, allocations - before, context);
+    }
+}
+
+void test_released_slots_are_recycled_with_default_values()
+{
+    std::string full = encode(*sampleMessage(Message::MessageType::SBPosition, 5));
+    std::string projected = "{\"msgId\":9,\"msgType\":4,\"msgLength\":0,\"msgConsignor\":2,\"line\":3}";
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    DecodeStatus status;
+
+    const Message* slot = Message::decode(full.data(), full.size(), document, status).get();
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    // the last handle is gone, the next decode of the type gets the same slot without the old fields
+    std::shared_ptr<Message> received = Message::decode(projected.data(), projected.size(), document, status, SBPositionMessage::Fields::table().mask("line"));
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_TRUE(received.get() == slot);
+    TEST_ASSERT_EQUAL_UINT(9, received->msgId);
+    TEST_ASSERT_EQUAL_INT(3, static_cast<SBPositionMessage&>(*received).line);
+    TEST_ASSERT_TRUE(SBPositionFields().sector == static_cast<SBPositionMessage&>(*received).sector);
+}
+
+void test_exhausted_pool_falls_back_to_the_heap()
+{
+    std::string payload = encode(*sampleMessage(Message::MessageType::SBState, 1));
+    StaticJsonDocument<MESSAGE_JSON_CAPACITY> document;
+    DecodeStatus status;
+    std::shared_ptr<Message> held[MESSAGES_POOL_SIZE];
+    for (size_t i = 0; i < MESSAGES_POOL_SIZE; i++)
+    {
+        held[i] = Message::decode(payload.data(), payload.size(), document, status);
+    }
+
+    size_t before = allocations;
+    std::shared_ptr<Message> extra = Message::decode(payload.data(), payload.size(), document, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_UINT(1, allocations - before);
+
+    held[0].reset();
+    before = allocations;
+    std::shared_ptr<Message> recycled = Message::decode(payload.data(), payload.size(), document, status);
+    TEST_ASSERT_EQUAL_UINT(0, allocations - before);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_decode_loop_does_not_allocate);
+    RUN_TEST(test_released_slots_are_recycled_with_default_values);
+    RUN_TEST(test_exhausted_pool_falls_back_to_the_heap);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief The structural index gives the same positions and decodes with every backend
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+#include "MessageStructural.h"
+
+#include <stdlib.h>
+#include <vector>
+
+static const StructuralBackend BACKENDS[] = {StructuralBackend::Scalar, StructuralBackend::Sse2, StructuralBackend::Avx2};
+
+static StructuralBackend initial;
+
+void setUp()
+{
+    initial = MessageStructural::backend();
+}
+
+void tearDown()
+{
+    MessageStructural::select(initial);
+}
+
+/**
+ * @brief Structural positions of an input found byte by byte
+ *
+ * @param input
+ * @return std::vector<size_t>
+ */
+static std::vector<size_t> expectedPositions(const std::string& input)
+{
+    std::vector<size_t> retVal;
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        if (MessageStructural::isStructural(input[i]))
+        {
+            retVal.push_back(i);
+        }
+    }
+    return retVal;
+}
+
+void test_scalar_is_always_supported()
+{
+    TEST_ASSERT_TRUE(MessageStructural::supports(StructuralBackend::Scalar));
+    TEST_ASSERT_TRUE(MessageStructural::supports(MessageStructural::backend()));
+}
+
+void test_sse2_is_preferred_over_avx2()
+{
+    StructuralBackend expected = MessageStructural::supports(StructuralBackend::Sse2) ? StructuralBackend::Sse2 : StructuralBackend::Scalar;
+    TEST_ASSERT_EQUAL_INT((int)expected, (int)initial);
+}
+
+void test_every_backend_finds_the_same_positions()
+{
+    const char alphabet[] = "\"\\:,{}[]\x01\n azAZ09\x7F\x80\xFF";
+    srand(19);
+    for (StructuralBackend backend : BACKENDS)
+    {
+        if (!MessageStructural::select(backend))
+        {
+            continue;
+        }
+        for (size_t length = 0; length < 300; length += 1 + length / 8)
+        {
+            for (int round = 0; round < 20; round++)
+            {
+                std::string input(length, ' ');
+                for (char& c : input)
+                {
+                    c = alphabet[rand() % (sizeof(alphabet) - 1)];
+                }
+                std::vector<size_t> expected = expectedPositions(input);
+
+                // every position reached one after the other, crossing windows
+                MessageStructuralIndex index(input.data(), input.size());
+                size_t position = 0;
+                for (size_t found : expected)
+                {
+                    position = index.nextFrom(position);
+                    TEST_ASSERT_EQUAL_UINT(found, position);
+                    position++;
+                }
+                TEST_ASSERT_EQUAL_UINT(input.size(), index.nextFrom(position));
+
+                // jumps forward and back again
+                MessageStructuralIndex jumps(input.data(), input.size());
+                for (size_t from = input.size(); from-- > 0;)
+                {
+                    size_t next = input.size();
+                    for (size_t found : expected)
+                    {
+                        if (found >= from)
+                        {
+                            next = found;
+                            break;
+                        }
+                    }
+                    TEST_ASSERT_EQUAL_UINT(next, jumps.nextFrom(from));
+                }
+            }
+        }
+    }
+}
+
+void test_every_backend_decodes_the_same()
+{
+    std::vector<std::string> payloads;
+    std::shared_ptr<Message> batch[Message::MESSAGE_TYPES];
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        batch[type - 1] = sampleMessage((Message::MessageType)type, 11);
+        std::string payload = encode(*batch[type - 1]);
+        payloads.push_back(payload);
+        payloads.push_back(payload.substr(0, payload.size() / 2));
+        payloads.push_back(payload.substr(0, 1) + "\"pad\":\"" + std::string(100, '\\') + "\"," + payload.substr(1));
+        payloads.push_back(payload.substr(0, 1) + "\"pad\":[" + std::string(80, '{') + "]," + payload.substr(1));
+    }
+    char frame[4096];
+    size_t length = Message::serializeBatch(batch, Message::MESSAGE_TYPES, frame, sizeof(frame));
+    payloads.push_back(std::string(frame, length));
+
+    std::vector<std::string> reference;
+    for (StructuralBackend backend : BACKENDS)
+    {
+        if (!MessageStructural::select(backend))
+        {
+            continue;
+        }
+        std::vector<std::string> outcomes;
+        for (const std::string& payload : payloads)
+        {
+            DecodeStatus status;
+            std::shared_ptr<Message> received = decode(payload, status);
+            outcomes.push_back(outcome(received, status));
+        }
+        std::shared_ptr<Message> received[Message::MESSAGE_TYPES];
+        Message::BatchResult result = Message::translateJsonArray(frame, length, received, Message::MESSAGE_TYPES);
+        outcomes.push_back(std::to_string(result.items) + "/" + std::to_string(result.failed) + "/" + std::to_string(result.complete));
+
+        if (reference.empty())
+        {
+            reference = outcomes;
+            continue;
+        }
+        for (size_t i = 0; i < outcomes.size(); i++)
+        {
+            TEST_ASSERT_EQUAL_STRING(reference[i].c_str(), outcomes[i].c_str());
+        }
+    }
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_scalar_is_always_supported);
+    RUN_TEST(test_sse2_is_preferred_over_avx2);
+    RUN_TEST(test_every_backend_finds_the_same_positions);
+    RUN_TEST(test_every_backend_decodes_the_same);
+    return UNITY_END();
+}
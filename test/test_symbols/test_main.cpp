@@ -0,0 +1,172 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Symbols of the closed vocabularies and strings outside of them
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_seeded_symbols()
+{
+    MessageSymbol empty;
+    TEST_ASSERT_EQUAL_STRING("", empty.c_str());
+    TEST_ASSERT_TRUE(empty.seeded());
+    MessageSymbol unset = "-1";
+    TEST_ASSERT_TRUE(unset.seeded());
+    TEST_ASSERT_TRUE(unset == "-1");
+    MessageSymbol null = "null";
+    TEST_ASSERT_TRUE(null.seeded());
+
+    MessageSymbol symbol;
+    TEST_ASSERT_TRUE(MessageSymbol::fromSeededCode(unset.id(), symbol));
+    TEST_ASSERT_TRUE(symbol == unset);
+    TEST_ASSERT_FALSE(MessageSymbol::fromSeededCode(MessageSymbol::seededCount(), symbol));
+}
+
+void test_plant_vocabulary_is_seeded()
+{
+    static_assert(sizeof(MessageSymbol) == MESSAGE_SYMBOL_LENGTH + 2, "a symbol is its size byte and the inline characters or the code");
+    for (const char* name : {"idle", "handover", "sector1", "package", "west"})
+    {
+        MessageSymbol symbol = name;
+        TEST_ASSERT_TRUE_MESSAGE(symbol.seeded(), name);
+        TEST_ASSERT_EQUAL_STRING(name, symbol.c_str());
+    }
+}
+
+void test_runtime_strings_get_codes_until_the_table_is_full()
+{
+    MessageSymbol first;
+    TEST_ASSERT_TRUE(MessageSymbol::intern("runtime-first", 13, first));
+    TEST_ASSERT_TRUE(first.interned());
+    TEST_ASSERT_FALSE(first.seeded());
+    TEST_ASSERT_TRUE(first.id() >= MessageSymbol::seededCount());
+
+    size_t interned = 1;
+    for (unsigned int i = 0; i < MESSAGE_SYMBOL_CAPACITY + 8; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "runtime-%u", i);
+        MessageSymbol symbol = name;
+        MessageSymbol again = name;
+        interned += symbol.interned() ? 1 : 0;
+        TEST_ASSERT_TRUE(symbol == again);
+        TEST_ASSERT_TRUE(symbol.interned() == again.interned());
+        TEST_ASSERT_EQUAL_STRING(name, symbol.c_str());
+        TEST_ASSERT_EQUAL_UINT(strlen(name), symbol.length());
+    }
+    TEST_ASSERT_TRUE(interned <= MESSAGE_SYMBOL_CAPACITY);
+
+    // once full, new strings stay inline, the interned ones keep their codes
+    MessageSymbol overflow = "runtime-overflow";
+    TEST_ASSERT_FALSE(overflow.interned());
+    TEST_ASSERT_TRUE(overflow == "runtime-overflow");
+    TEST_ASSERT_TRUE(overflow == MessageSymbol("runtime-overflow"));
+    TEST_ASSERT_TRUE(overflow != first);
+    MessageSymbol found = "runtime-first";
+    TEST_ASSERT_EQUAL_UINT(first.id(), found.id());
+}
+
+void test_equality_by_content()
+{
+    MessageSymbol left = "sector7";
+    MessageSymbol right;
+    right = String("sector7");
+    MessageSymbol other = "sector8";
+    TEST_ASSERT_TRUE(left == right);
+    TEST_ASSERT_TRUE(left != other);
+    TEST_ASSERT_TRUE(left == "sector7");
+    TEST_ASSERT_TRUE(left == String("sector7"));
+    TEST_ASSERT_EQUAL_UINT(7, left.length());
+}
+
+void test_unseeded_symbol_roundtrip()
+{
+    SBAvailableMessage sent;
+    sent.msgId = 5;
+    sent.sector = "unseeded-sector";
+    sent.targetReg = "-1";
+    sent.updateLength();
+    for (WireFormat format : TEST_FORMATS)
+    {
+        DecodeStatus status;
+        std::shared_ptr<Message> received = decode(encode(sent, format), status);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+        assertSameMessage(sent, *received, "unseeded");
+    }
+}
+
+void test_many_distinct_strings_decode()
+{
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        char payload[160];
+        snprintf(payload, sizeof(payload), "{\"msgId\":%u,\"msgType\":3,\"msgLength\":0,\"msgConsignor\":1,\"sector\":\"sector-%u\",\"targetReg\":\"-1\"}", i + 1, i);
+        DecodeStatus status;
+        std::shared_ptr<Message> received = decode(payload, status);
+        TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+        char expected[32];
+        snprintf(expected, sizeof(expected), "sector-%u", i);
+        SBAvailableMessage& available = static_cast<SBAvailableMessage&>(*received);
+        TEST_ASSERT_EQUAL_STRING(expected, available.sector.c_str());
+        TEST_ASSERT_FALSE(available.sector.seeded());
+        TEST_ASSERT_TRUE(available.targetReg.seeded());
+    }
+}
+
+void test_unseeded_and_seeded_symbols_differ()
+{
+    MessageSymbol seeded = "-1";
+    MessageSymbol unseeded = "-2";
+    MessageSymbol empty = "";
+    TEST_ASSERT_TRUE(seeded != unseeded);
+    TEST_ASSERT_TRUE(unseeded != empty);
+    TEST_ASSERT_TRUE(empty == MessageSymbol());
+    unseeded = "-1";
+    TEST_ASSERT_TRUE(unseeded.seeded());
+    TEST_ASSERT_TRUE(seeded == unseeded);
+
+    MessageSymbol overlong = std::string(MESSAGE_SYMBOL_LENGTH + 1, 'o').c_str();
+    TEST_ASSERT_TRUE(overlong == empty);
+}
+
+void test_overlong_symbol_is_invalid()
+{
+    std::string payload = "{\"msgId\":5,\"msgType\":3,\"msgLength\":0,\"msgConsignor\":1,\"sector\":\"" +
+                          std::string(MESSAGE_SYMBOL_LENGTH + 1, 's') + "\",\"targetReg\":\"-1\"}";
+    DecodeStatus status;
+    std::shared_ptr<Message> received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Invalid, status);
+    TEST_ASSERT_EQUAL_UINT(0, received->msgId);
+
+    payload.replace(payload.find('s', payload.find("\"sector\":") + 9), MESSAGE_SYMBOL_LENGTH + 1, std::string(MESSAGE_SYMBOL_LENGTH, 's'));
+    received = decode(payload, status);
+    TEST_ASSERT_STATUS(DecodeStatus::Ok, status);
+    TEST_ASSERT_EQUAL_UINT(MESSAGE_SYMBOL_LENGTH, static_cast<SBAvailableMessage&>(*received).sector.length());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_seeded_symbols);
+    RUN_TEST(test_plant_vocabulary_is_seeded);
+    RUN_TEST(test_runtime_strings_get_codes_until_the_table_is_full);
+    RUN_TEST(test_equality_by_content);
+    RUN_TEST(test_unseeded_symbol_roundtrip);
+    RUN_TEST(test_many_distinct_strings_decode);
+    RUN_TEST(test_unseeded_and_seeded_symbols_differ);
+    RUN_TEST(test_overlong_symbol_is_invalid);
+    return UNITY_END();
+}
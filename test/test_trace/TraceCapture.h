@@ -0,0 +1,44 @@
+/**
+ * @file TraceCapture.h
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Logging macros that write into a string instead of the console
+ * @version 0.1
+ * @date 2020-06-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * Include after MessageTrace.h, the trace macros expand to the logging
+ * macros at their use, so every printed trace site ends up in traceLog.
+ *
+ */
+#ifndef TRACECAPTURE_H__
+#define TRACECAPTURE_H__
+
+#include <string>
+
+#include "MessageTrace.h"
+
+/**
+ * @brief Everything printed by the trace sites, one line per site
+ *
+ */
+extern std::string traceLog;
+
+#undef DBFUNCCALLln
+#undef DBINFO2ln
+#undef DBWARNING
+#undef DBWARNINGln
+
+#define DBFUNCCALLln(x)     traceLog.append(x).append("\n")
+#define DBINFO2ln(x)        traceLog.append(x).append("\n")
+#define DBWARNING(x)        traceLog.append(x)
+#define DBWARNINGln(x)      traceLog.append(x).append("\n")
+
+/**
+ * @brief Trace one site of every level in a unit built with MESSAGE_TRACE_NONE and without counters
+ *
+ * @param evaluated - incremented by every trace argument that is evaluated
+ */
+void traceEveryLevelWithoutTracing(int& evaluated);
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Call counters of the trace sites and the compile-time trace levels
+ * @version 0.1
+ * @date 2020-06-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ * The library sources are built without counters, so the only counters in
+ * this binary are the trace sites below.
+ *
+ */
+#define MESSAGE_TRACE_LEVEL MESSAGE_TRACE_INFOS
+#define MESSAGE_TRACE_COUNTERS 1
+
+#include <unity.h>
+
+#include "TraceCapture.h"
+
+std::string traceLog;
+
+/**
+ * @brief Print into a string
+ *
+ */
+class StringPrint : public Print
+{
+public:
+
+    std::string text;
+
+    size_t write(uint8_t c) override
+    {
+        this->text += (char)c;
+        return 1;
+    }
+};
+
+void setUp()
+{
+    traceLog.clear();
+}
+
+void tearDown()
+{
+}
+
+static void traceCall()
+{
+    MESSAGE_FUNCCALLln("traceCall()");
+}
+
+static void traceAlpha()
+{
+    MESSAGE_FUNCCALLln("traceAlpha()");
+}
+
+static void traceBeta()
+{
+    MESSAGE_FUNCCALLln("traceBeta()");
+}
+
+static void traceEveryLevel()
+{
+    MESSAGE_FUNCCALLln("traceEveryLevel()");
+    MESSAGE_INFOln("infos");
+    MESSAGE_WARNING("warnings ");
+    MESSAGE_WARNINGln("line");
+}
+
+/**
+ * @brief Listed counter of a trace site
+ *
+ * @param name
+ * @return const MessageTraceCounter* - nullptr if the site was never hit
+ */
+static const MessageTraceCounter* counterOf(const char* name)
+{
+    for (const MessageTraceCounter* counter = MessageTraceCounter::first(); counter; counter = counter->next())
+    {
+        if (strcmp(counter->name(), name) == 0)
+        {
+            return counter;
+        }
+    }
+    return nullptr;
+}
+
+static size_t listedCounters()
+{
+    size_t retVal = 0;
+    for (const MessageTraceCounter* counter = MessageTraceCounter::first(); counter; counter = counter->next())
+    {
+        retVal++;
+    }
+    return retVal;
+}
+
+void test_counters_are_listed_on_their_first_hit()
+{
+    TEST_ASSERT_NULL(counterOf("traceCall()"));
+    for (int i = 0; i < 3; i++)
+    {
+        traceCall();
+    }
+    const MessageTraceCounter* counter = counterOf("traceCall()");
+    TEST_ASSERT_NOT_NULL(counter);
+    TEST_ASSERT_EQUAL_UINT(3, counter->hits());
+    TEST_ASSERT_TRUE(counter == MessageTraceCounter::first());
+}
+
+void test_reset_zeroes_the_counters_and_keeps_them_listed()
+{
+    traceCall();
+    size_t listed = listedCounters();
+    MessageTraceCounter::reset();
+    TEST_ASSERT_EQUAL_UINT(listed, listedCounters());
+    TEST_ASSERT_EQUAL_UINT(0, counterOf("traceCall()")->hits());
+    traceCall();
+    TEST_ASSERT_EQUAL_UINT(1, counterOf("traceCall()")->hits());
+    TEST_ASSERT_EQUAL_UINT(listed, listedCounters());
+}
+
+void test_report_prints_one_line_per_counter()
+{
+    traceCall();
+    MessageTraceCounter::reset();
+    traceBeta();
+    traceAlpha();
+    traceAlpha();
+    traceCall();
+
+    // counters are listed in front, the last one hit for the first time comes first
+    StringPrint output;
+    MessageTraceCounter::report(output);
+    TEST_ASSERT_EQUAL_STRING("traceAlpha() 2\ntraceBeta() 1\ntraceCall() 1\n", output.text.c_str());
+}
+
+void test_levels_above_the_trace_level_compile_out()
+{
+    traceEveryLevel();
+    traceEveryLevel();
+    TEST_ASSERT_EQUAL_STRING("infos\nwarnings line\ninfos\nwarnings line\n", traceLog.c_str());
+    TEST_ASSERT_EQUAL_UINT(2, counterOf("traceEveryLevel()")->hits());
+
+    traceLog.clear();
+    size_t listed = listedCounters();
+    int evaluated = 0;
+    traceEveryLevelWithoutTracing(evaluated);
+    TEST_ASSERT_EQUAL_STRING("", traceLog.c_str());
+    TEST_ASSERT_EQUAL_INT(0, evaluated);
+    TEST_ASSERT_EQUAL_UINT(listed, listedCounters());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counters_are_listed_on_their_first_hit);
+    RUN_TEST(test_reset_zeroes_the_counters_and_keeps_them_listed);
+    RUN_TEST(test_report_prints_one_line_per_counter);
+    RUN_TEST(test_levels_above_the_trace_level_compile_out);
+    return UNITY_END();
+}
@@ -0,0 +1,37 @@
+/**
+ * @file trace_none.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Trace sites of a unit that is built with tracing and counters turned off
+ * @version 0.1
+ * @date 2020-06-09
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#define MESSAGE_TRACE_LEVEL MESSAGE_TRACE_NONE
+#define MESSAGE_TRACE_COUNTERS 0
+
+#include "TraceCapture.h"
+
+/**
+ * @brief Count that a trace argument was evaluated, not static so that it is not unused when tracing is off
+ *
+ * @param evaluated
+ * @param text
+ * @return const char* - the text
+ */
+const char* evaluate(int& evaluated, const char* text)
+{
+    evaluated++;
+    return text;
+}
+
+void traceEveryLevelWithoutTracing(int& evaluated)
+{
+    // only read by the trace arguments, which are dropped in this unit
+    (void)evaluated;
+    MESSAGE_FUNCCALLln(evaluate(evaluated, "none calls"));
+    MESSAGE_INFOln(evaluate(evaluated, "none infos"));
+    MESSAGE_WARNING(evaluate(evaluated, "none "));
+    MESSAGE_WARNINGln(evaluate(evaluated, "warnings"));
+}
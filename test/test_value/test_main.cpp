@@ -0,0 +1,95 @@
+/**
+ * @file test_main.cpp
+ * @author Philip Zellweger (philip.zellweger@hsr.ch)
+ * @brief Messages by value decode and encode like the message objects
+ * @version 0.1
+ * @date 2020-06-02
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "../MessageTestSupport.h"
+#include "MessageMetrics.h"
+#include "MessageValue.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_value_roundtrip_every_type_and_format()
+{
+    for (size_t type = 1; type <= Message::MESSAGE_TYPES; type++)
+    {
+        std::shared_ptr<Message> sent = sampleMessage((Message::MessageType)type, 12);
+        for (WireFormat format : TEST_FORMATS)
+        {
+            std::string payload = encode(*sent, format);
+            MessageValue value = decodeMessageValue(payload.data(), payload.size());
+            TEST_ASSERT_EQUAL_UINT(type, value.index());
+            assertSameMessage(*sent, *toMessage(value), "value");
+
+            char buffer[512];
+            size_t length = encodeMessageValue(value, buffer, sizeof(buffer), format);
+            TEST_ASSERT_EQUAL_UINT(payload.size(), length);
+            TEST_ASSERT_EQUAL_UINT(length, measureMessageValue(value, format));
+            TEST_ASSERT_EQUAL_MEMORY(payload.data(), buffer, length);
+        }
+    }
+}
+
+void test_value_from_message_and_back()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SBToSVHandshake, 13);
+    MessageValue value = toMessageValue(*sent);
+    assertSameMessage(*sent, *toMessage(value), "toMessageValue");
+    updateMessageLength(value);
+    TEST_ASSERT_EQUAL_UINT(sent->msgLength, std::get<SBToSVHandshakeValue>(value).msgLength);
+}
+
+void test_failed_decodes_are_empty()
+{
+    const char* payloads[] = {"", "{", "{\"msgId\":1,\"msgType\":99,\"msgLength\":0,\"msgConsignor\":1}", "[1,2]"};
+    for (const char* payload : payloads)
+    {
+        MessageValue value = decodeMessageValue(payload, strlen(payload));
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(0, value.index(), payload);
+    }
+    char buffer[64];
+    TEST_ASSERT_EQUAL_UINT(0, encodeMessageValue(MessageValue(), buffer, sizeof(buffer)));
+    TEST_ASSERT_NULL(toMessage(MessageValue()));
+}
+
+void test_value_decodes_are_counted_once()
+{
+    std::shared_ptr<Message> sent = sampleMessage(Message::MessageType::SVState, 14);
+    std::string payload = encode(*sent);
+    const char* unknown = "{\"msgId\":1,\"msgType\":99,\"msgLength\":0,\"msgConsignor\":1}";
+    MessageMetrics::reset();
+    decodeMessageValue(payload.data(), payload.size());
+    decodeMessageValue(payload.data(), payload.size() - 1);
+    decodeMessageValue(unknown, strlen(unknown));
+    char buffer[512];
+    encodeMessageValue(toMessageValue(*sent), buffer, sizeof(buffer));
+
+    MessageMetricsSnapshot snapshot;
+    MessageMetrics::snapshot(snapshot);
+    const MessageTypeMetrics& metrics = snapshot.types[(size_t)Message::MessageType::SVState];
+    TEST_ASSERT_EQUAL_UINT(1, metrics.decoded);
+    TEST_ASSERT_EQUAL_UINT(1, metrics.decodeErrors);
+    TEST_ASSERT_EQUAL_UINT(1, metrics.encoded);
+    TEST_ASSERT_EQUAL_UINT(1, snapshot.types[0].decodeErrors);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_value_roundtrip_every_type_and_format);
+    RUN_TEST(test_value_from_message_and_back);
+    RUN_TEST(test_failed_decodes_are_empty);
+    RUN_TEST(test_value_decodes_are_counted_once);
+    return UNITY_END();
+}